@@ -0,0 +1,413 @@
+﻿//Matrix2x各类运算的性能测试。
+//先测出本机的峰值：浮点峰值用一串互不依赖的乘加，带宽峰值用原地的a += s * b，
+//(和矩阵+=一样每个元素读两个写一个，写的那一行已经在缓存里，不会多读一次)，
+//带宽和数据量所在的缓存层级有关，所以每项测试都在和自己相同的数据量下单独测一次带宽作为上限。
+//然后对矩阵乘法、逐元素运算、求逆/解方程、归约按不同尺寸(很小、放得进缓存、超出缓存、非方阵、奇数尺寸)测速，
+//每项给出GFLOP/s、GB/s，以及占屋顶线模型(roofline)上限的百分比：上限 = min(浮点峰值, 算术强度 * 带宽峰值)。
+//结果同时写成JSON，方便前后对比。
+//用法：bench [--quick] [--threads n] [--out 文件名] [--min-time 秒]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <map>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#include "eigen1.h"
+#include "eigen1_parallel.h"
+#include "eigen1_reduce.h"
+#include "eigen1_solver.h"
+
+using Eigen1::Matrix2x;
+
+namespace
+{
+	//一项测试的结果
+	struct Result
+	{
+		std::string kernel;
+		std::string shape;
+		double seconds;//单次用时
+		double flops;//单次浮点运算次数
+		double bytes;//单次至少要搬的字节数
+		double footprint;//用到的数据一共多少字节
+	};
+
+	double min_time = 0.2;//每项至少测这么久
+
+	double now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//反复运行f，直到累计时间超过min_time，取5轮里最快的一轮的平均单次用时
+	double time_it(const std::function<void()>& f)
+	{
+		f();
+		double best = 1e300;
+		for (int round = 0; round < 5; round++)
+		{
+			long long reps = 0;
+			double t0 = now();
+			double t1 = t0;
+			do
+			{
+				f();
+				reps++;
+				t1 = now();
+			} while (t1 - t0 < min_time / 5);
+			best = std::min(best, (t1 - t0) / reps);
+		}
+		return best;
+	}
+
+	//防止编译器把没用到的结果优化掉
+	volatile double sink = 0;
+
+	void fill_random(Matrix2x<double>& m, unsigned int seed)
+	{
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<double> dist(-1.0, 1.0);
+		double* p = m.get_data();
+		for (std::size_t k = 0; k < m.size(); k++)
+		{
+			p[k] = dist(gen);
+		}
+	}
+
+	//峰值测试里乘加的写法。编译目标带FMA(定义了FP_FAST_FMA)时用std::fma，保证是一条融合乘加；
+	//否则std::fma会变成库函数调用，只能写成乘法加加法，这时的峰值就是分开乘、加的峰值。
+	//按标准模式编译时编译器默认不会自己把a * b + c合成FMA，所以两种写法各自测到的就是对应指令的峰值
+#ifdef FP_FAST_FMA
+	const char* const peak_form = "fma";
+#else
+	const char* const peak_form = "mul+add";
+#endif
+
+	//浮点峰值：每个线程对一小块数组反复做互不依赖的乘加(每次记2次浮点运算)，数组放在L1里，编译器可以向量化
+	double measure_flops_peak()
+	{
+		const int width = 64;
+		const long long iters = 1 << 20;
+		std::vector<double> partial(Eigen1::get_num_threads(), 0.0);
+		double t = time_it([&]() {
+			Eigen1::parallel_run(Eigen1::get_num_threads(), [&](int id) {
+				double acc[width];
+				for (int j = 0; j < width; j++)
+				{
+					acc[j] = 1.0 + j * 1e-3;
+				}
+				const double a = 0.999999, b = 1e-7;
+				for (long long it = 0; it < iters / width; it++)
+				{
+					for (int j = 0; j < width; j++)
+					{
+#ifdef FP_FAST_FMA
+						acc[j] = std::fma(acc[j], a, b);
+#else
+						acc[j] = acc[j] * a + b;
+#endif
+					}
+				}
+				double s = 0;
+				for (int j = 0; j < width; j++)
+				{
+					s += acc[j];
+				}
+				partial[id] = s;
+			});
+		});
+		for (double s : partial)
+		{
+			sink = sink + s;
+		}
+		return 2.0 * iters * Eigen1::get_num_threads() / t / 1e9;
+	}
+
+	//带宽峰值：a += s * b，两个数组一共bytes字节；数据量小时多线程不划算，直接单线程
+	double measure_bandwidth_peak(double bytes)
+	{
+		const long long n = std::max(256LL, (long long)(bytes / 16));
+		Matrix2x<double> a(1, (int)n), b(1, (int)n);
+		fill_random(b, 0);
+		double* pa = a.get_data();
+		const double* pb = b.get_data();
+		auto axpy = [=](long long lo, long long hi) {
+			for (long long i = lo; i < hi; i++)
+			{
+				pa[i] += 1e-3 * pb[i];
+			}
+		};
+		double t = time_it([&]() {
+			if (n < (1 << 16))
+			{
+				axpy(0, n);
+			}
+			else
+			{
+				Eigen1::parallel_for(0, n, 1 << 14, axpy);
+			}
+		});
+		sink = sink + pa[n / 2];
+		return 3.0 * 8 * n / t / 1e9;
+	}
+
+	struct Peak
+	{
+		double gflops;
+		std::map<double, double> bandwidth;//数据量字节数 -> GB/s
+
+		//数据量为footprint时的带宽，第一次用到时现测
+		double gbps(double footprint)
+		{
+			auto it = bandwidth.find(footprint);
+			if (it == bandwidth.end())
+			{
+				it = bandwidth.insert(std::make_pair(footprint, measure_bandwidth_peak(footprint))).first;
+			}
+			return it->second;
+		}
+	};
+
+	std::string shape_of(int m, int n, int k)
+	{
+		std::ostringstream os;
+		os << m << "x" << k << "*" << k << "x" << n;
+		return os.str();
+	}
+
+	std::string shape_of(int m, int n)
+	{
+		std::ostringstream os;
+		os << m << "x" << n;
+		return os.str();
+	}
+
+	//c = a * b
+	void bench_matmul(std::vector<Result>& out, int m, int n, int k)
+	{
+		Matrix2x<double> a(m, k), b(k, n), c(m, n);
+		fill_random(a, 1);
+		fill_random(b, 2);
+		double t = time_it([&]() { gemm(1.0, a, b, 0.0, c); });
+		out.push_back({ "gemm", shape_of(m, n, k), t, 2.0 * m * n * k, 8.0 * ((double)m * k + (double)k * n + (double)m * n), 8.0 * ((double)m * k + (double)k * n + (double)m * n) });
+		t = time_it([&]() { gemm(true, false, 1.0, a, c, 0.0, b); });
+		out.push_back({ "gemm_tn", shape_of(k, n, m), t, 2.0 * m * n * k, 8.0 * ((double)m * k + (double)k * n + (double)m * n), 8.0 * ((double)m * k + (double)k * n + (double)m * n) });
+	}
+
+	//逐元素运算：+=、标量*=、会生成新矩阵的+
+	void bench_elementwise(std::vector<Result>& out, int m, int n)
+	{
+		Matrix2x<double> a(m, n), b(m, n);
+		fill_random(a, 3);
+		fill_random(b, 4);
+		double size = (double)m * n;
+		double t = time_it([&]() { a += b; });
+		out.push_back({ "add_assign", shape_of(m, n), t, size, 24.0 * size, 16.0 * size });
+		t = time_it([&]() { a *= 0.5; });
+		out.push_back({ "scale", shape_of(m, n), t, size, 16.0 * size, 8.0 * size });
+		t = time_it([&]() { Matrix2x<double> c = a + b; sink = sink + c.get_data()[0]; });
+		out.push_back({ "add", shape_of(m, n), t, size, 24.0 * size, 24.0 * size });
+	}
+
+	//求逆和解方程，右端项取8列
+	void bench_solve(std::vector<Result>& out, int n)
+	{
+		Matrix2x<double> a(n, n), spd(n, n), rhs(n, 8);
+		fill_random(a, 5);
+		for (int i = 0; i < n; i++)
+		{
+			a[i][i] += n;
+		}
+		gemm(true, false, 1.0, a, a, 0.0, spd);
+		fill_random(rhs, 6);
+		double bytes = 8.0 * n * n;
+		double t = time_it([&]() { Matrix2x<double> r = a.inv(); sink = sink + r.get_data()[0]; });
+		out.push_back({ "inv", shape_of(n, n), t, 2.0 * n * n * n, 2.0 * bytes, 2.0 * bytes });
+		t = time_it([&]() { Eigen1::Cholesky<double> c(spd); Matrix2x<double> x = c.solve(rhs); sink = sink + x.get_data()[0]; });
+		out.push_back({ "cholesky_solve", shape_of(n, n), t, n * (double)n * n / 3.0 + 4.0 * n * n * 8, bytes, bytes });
+		t = time_it([&]() { Eigen1::HouseholderQR<double> q(a); Matrix2x<double> x = q.solve(rhs); sink = sink + x.get_data()[0]; });
+		out.push_back({ "qr_solve", shape_of(n, n), t, 4.0 * n * n * n / 3.0 + 8.0 * n * n * 8, bytes, bytes });
+	}
+
+	//归约：求和、最大绝对值
+	void bench_reduce(std::vector<Result>& out, int m, int n)
+	{
+		Matrix2x<double> a(m, n);
+		fill_random(a, 7);
+		double size = (double)m * n;
+		double t = time_it([&]() {
+			sink = sink + Eigen1::sum(a);
+		});
+		out.push_back({ "sum", shape_of(m, n), t, size, 8.0 * size, 8.0 * size });
+		t = time_it([&]() {
+			sink = sink + Eigen1::norm_inf(a);
+		});
+		out.push_back({ "max_abs", shape_of(m, n), t, size, 8.0 * size, 8.0 * size });
+		Matrix2x<double> c(1, n);
+		t = time_it([&]() {
+			Eigen1::col_sum(a, c);
+			sink = sink + c[0][0];
+		});
+		//Kahan求和每个元素4次加减
+		out.push_back({ "col_sum", shape_of(m, n), t, 4.0 * size, 8.0 * size, 8.0 * size });
+		Matrix2x<double> v(1, n);
+		fill_random(v, 8);
+		t = time_it([&]() {
+			Eigen1::add_row_vector(a, v);
+		});
+		out.push_back({ "add_row_vector", shape_of(m, n), t, size, 16.0 * size, 8.0 * size });
+	}
+
+	//屋顶线模型下的上限(GFLOP/s)
+	double roofline(const Result& r, Peak& peak)
+	{
+		double intensity = r.flops / r.bytes;
+		return std::min(peak.gflops, intensity * peak.gbps(r.footprint));
+	}
+
+	void print_table(const std::vector<Result>& results, Peak& peak)
+	{
+		std::cout << std::left << std::setw(16) << "kernel" << std::setw(22) << "shape" << std::right
+			<< std::setw(12) << "time(us)" << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(10) << "peakGB/s" << std::setw(10) << "%roof" << std::endl;
+		for (const Result& r : results)
+		{
+			double gf = r.flops / r.seconds / 1e9;
+			double gb = r.bytes / r.seconds / 1e9;
+			std::cout << std::left << std::setw(16) << r.kernel << std::setw(22) << r.shape << std::right << std::fixed
+				<< std::setw(12) << std::setprecision(2) << r.seconds * 1e6
+				<< std::setw(10) << std::setprecision(2) << gf
+				<< std::setw(10) << std::setprecision(2) << gb
+				<< std::setw(10) << std::setprecision(2) << peak.gbps(r.footprint)
+				<< std::setw(10) << std::setprecision(1) << 100.0 * gf / roofline(r, peak) << std::endl;
+		}
+	}
+
+	bool write_json(const std::string& path, const std::vector<Result>& results, Peak& peak)
+	{
+		std::ofstream f(path);
+		if (!f)
+		{
+			return false;
+		}
+		f << std::setprecision(6);
+		f << "{\n";
+		f << "  \"threads\": " << Eigen1::get_num_threads() << ",\n";
+		f << "  \"peak_gflops\": " << peak.gflops << ",\n";
+		f << "  \"peak_form\": \"" << peak_form << "\",\n";
+		f << "  \"peak_gbps\": [";
+		for (auto it = peak.bandwidth.begin(); it != peak.bandwidth.end(); ++it)
+		{
+			f << (it != peak.bandwidth.begin() ? ", " : "") << "{\"bytes\": " << it->first << ", \"gbps\": " << it->second << "}";
+		}
+		f << "],\n";
+		f << "  \"results\": [\n";
+		for (std::size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			double gf = r.flops / r.seconds / 1e9;
+			f << "    {\"kernel\": \"" << r.kernel << "\", \"shape\": \"" << r.shape << "\""
+				<< ", \"seconds\": " << r.seconds
+				<< ", \"gflops\": " << gf
+				<< ", \"gbps\": " << r.bytes / r.seconds / 1e9
+				<< ", \"intensity\": " << r.flops / r.bytes
+				<< ", \"peak_gbps\": " << peak.gbps(r.footprint)
+				<< ", \"roofline_pct\": " << 100.0 * gf / roofline(r, peak) << "}"
+				<< (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		f << "  ]\n";
+		f << "}\n";
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool quick = false;
+	std::string out_path = "bench.json";
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--quick") == 0)
+		{
+			quick = true;
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			Eigen1::set_num_threads(std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+		{
+			out_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+		{
+			min_time = std::atof(argv[++i]);
+		}
+		else
+		{
+			std::cout << "用法：bench [--quick] [--threads n] [--out 文件名] [--min-time 秒]" << std::endl;
+			return 1;
+		}
+	}
+
+	Peak peak;
+	peak.gflops = measure_flops_peak();
+	std::cout << "线程数 " << Eigen1::get_num_threads() << "，浮点峰值 " << peak.gflops << " GFLOP/s(" << peak_form << ")，内存带宽 " << peak.gbps(256.0 * 1024 * 1024) << " GB/s" << std::endl;
+
+	std::vector<Result> results;
+
+	//矩阵乘法：很小、缓存内、超出缓存、非方阵、奇数尺寸
+	std::vector<std::vector<int>> mm = { {4, 4, 4}, {32, 32, 32}, {96, 96, 96}, {127, 127, 127}, {333, 251, 517}, {1000, 1000, 64}, {4096, 32, 256} };
+	if (!quick)
+	{
+		mm.push_back({ 1024, 1024, 1024 });
+		mm.push_back({ 2048, 2048, 2048 });
+	}
+	for (const auto& s : mm)
+	{
+		bench_matmul(results, s[0], s[1], s[2]);
+	}
+
+	//逐元素和归约：放得进L1、L2、出缓存
+	std::vector<std::vector<int>> ew = { {16, 16}, {256, 256}, {1000, 999} };
+	if (!quick)
+	{
+		ew.push_back({ 4096, 4096 });
+	}
+	for (const auto& s : ew)
+	{
+		bench_elementwise(results, s[0], s[1]);
+		bench_reduce(results, s[0], s[1]);
+	}
+
+	//求逆和解方程
+	std::vector<int> sv = { 4, 33, 128 };
+	if (!quick)
+	{
+		sv.push_back(512);
+	}
+	for (int n : sv)
+	{
+		bench_solve(results, n);
+	}
+
+	print_table(results, peak);
+	if (write_json(out_path, results, peak))
+	{
+		std::cout << "结果已写入 " << out_path << std::endl;
+	}
+	else
+	{
+		std::cout << "无法写入 " << out_path << std::endl;
+	}
+	return 0;
+}
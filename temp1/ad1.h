@@ -8,6 +8,9 @@
 #include <algorithm>
 #include <functional>
 
+#include "grad_mode.h"
+#include "eigen1_stats.h"
+
 namespace autodiff {
 
     class Var {
@@ -44,22 +47,36 @@ namespace autodiff {
         };
 
         NodePtr node;
+        double plain_value;  // ʱֵ, ʱnodeΪ
+
+        // ¼ӽڵľֲ, ӽڵûnodeʱ
+        void link(const Var& x, double partial) {
+            if (x.node) node->children.emplace_back(x.node, partial);
+        }
 
     public:
-        // 캯
-        explicit Var(double value = 0.0) : node(std::make_shared<Node>(value)) {}
+        // 캯, NoGradGuardﲻڵ
+        explicit Var(double value = 0.0)
+            : node(AD::grad_enabled() ? std::make_shared<Node>(value) : nullptr), plain_value(value) {
+            if (node) EIGEN1_STAT(stat_var_node, "ad1::Var", sizeof(Node));
+        }
 
         // ȡֵ
-        double value() const { return node->value; }
+        double value() const { return node ? node->value : plain_value; }
 
         // ȡݶ
-        double grad() const { return node->grad; }
+        double grad() const { return node ? node->grad : 0.0; }
 
         // ݶ
-        void set_grad(double g) { node->grad = g; }
+        void set_grad(double g) { if (node) node->grad = g; }
 
         // 򴫲
         void backward() {
+            if (!node) {
+                std::cout << "ڲģʽɵ, ûмͼ" << std::endl;
+                return;
+            }
+
             // ȷȷ˳
             std::vector<NodePtr> sorted_nodes;
             std::unordered_set<Node*> visited;
@@ -76,6 +93,7 @@ namespace autodiff {
 
         // ݶ
         void zero_grad() {
+            if (!node) return;
             std::unordered_set<Node*> visited;
             zero_grad(node, visited);
         }
@@ -122,73 +140,95 @@ namespace autodiff {
     };
 
     // ʵ
-    Var operator+(Var a, Var b) {
-        Var result(a.node->value + b.node->value);
-        result.node->children.emplace_back(a.node, 1.0);
-        result.node->children.emplace_back(b.node, 1.0);
+    inline Var operator+(Var a, Var b) {
+        Var result(a.value() + b.value());
+        if (result.node) {
+            result.link(a, 1.0);
+            result.link(b, 1.0);
+        }
         return result;
     }
 
-    Var operator-(Var a, Var b) {
-        Var result(a.node->value - b.node->value);
-        result.node->children.emplace_back(a.node, 1.0);
-        result.node->children.emplace_back(b.node, -1.0);
+    inline Var operator-(Var a, Var b) {
+        Var result(a.value() - b.value());
+        if (result.node) {
+            result.link(a, 1.0);
+            result.link(b, -1.0);
+        }
         return result;
     }
 
-    Var operator*(Var a, Var b) {
-        Var result(a.node->value * b.node->value);
-        result.node->children.emplace_back(a.node, b.node->value);
-        result.node->children.emplace_back(b.node, a.node->value);
+    inline Var operator*(Var a, Var b) {
+        Var result(a.value() * b.value());
+        if (result.node) {
+            result.link(a, b.value());
+            result.link(b, a.value());
+        }
         return result;
     }
 
-    Var operator/(Var a, Var b) {
-        Var result(a.node->value / b.node->value);
-        double b_val = b.node->value;
-        result.node->children.emplace_back(a.node, 1.0 / b_val);
-        result.node->children.emplace_back(b.node, -a.node->value / (b_val * b_val));
+    inline Var operator/(Var a, Var b) {
+        Var result(a.value() / b.value());
+        if (result.node) {
+            double b_val = b.value();
+            result.link(a, 1.0 / b_val);
+            result.link(b, -a.value() / (b_val * b_val));
+        }
         return result;
     }
 
-    Var operator-(Var x) {
-        Var result(-x.node->value);
-        result.node->children.emplace_back(x.node, -1.0);
+    inline Var operator-(Var x) {
+        Var result(-x.value());
+        if (result.node) {
+            result.link(x, -1.0);
+        }
         return result;
     }
 
     // ѧʵ
-    Var sin(Var x) {
-        Var result(std::sin(x.node->value));
-        result.node->children.emplace_back(x.node, std::cos(x.node->value));
+    inline Var sin(Var x) {
+        Var result(std::sin(x.value()));
+        if (result.node) {
+            result.link(x, std::cos(x.value()));
+        }
         return result;
     }
 
-    Var cos(Var x) {
-        Var result(std::cos(x.node->value));
-        result.node->children.emplace_back(x.node, -std::sin(x.node->value));
+    inline Var cos(Var x) {
+        Var result(std::cos(x.value()));
+        if (result.node) {
+            result.link(x, -std::sin(x.value()));
+        }
         return result;
     }
 
-    Var exp(Var x) {
-        Var result(std::exp(x.node->value));
-        result.node->children.emplace_back(x.node, result.node->value);
+    inline Var exp(Var x) {
+        Var result(std::exp(x.value()));
+        if (result.node) {
+            result.link(x, result.value());
+        }
         return result;
     }
 
-    Var log(Var x) {
-        Var result(std::log(x.node->value));
-        result.node->children.emplace_back(x.node, 1.0 / x.node->value);
+    inline Var log(Var x) {
+        Var result(std::log(x.value()));
+        if (result.node) {
+            result.link(x, 1.0 / x.value());
+        }
         return result;
     }
 
-    Var pow(Var x, Var y) {
-        Var result(std::pow(x.node->value, y.node->value));
-        double x_val = x.node->value;
-        double y_val = y.node->value;
-        result.node->children.emplace_back(x.node, y_val * std::pow(x_val, y_val - 1));
-        result.node->children.emplace_back(y.node, result.node->value * std::log(x_val));
+    inline Var pow(Var x, Var y) {
+        Var result(std::pow(x.value(), y.value()));
+        if (result.node) {
+            double x_val = x.value();
+            double y_val = y.value();
+            result.link(x, y_val * std::pow(x_val, y_val - 1));
+            result.link(y, result.value() * std::log(x_val));
+        }
         return result;
     }
 
+    using AD::NoGradGuard;
+
 } // namespace autodiff
\ No newline at end of file
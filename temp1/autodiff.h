@@ -7,6 +7,11 @@
 #include <vector>
 #include <set>
 #include <unordered_set>
+#include <memory>
+#include <cmath>
+
+#include "grad_mode.h"
+#include "eigen1_stats.h"
 
 //˼·ģһvarԶ΢ֵķģʽĻȻڲһnodeΪͼĽڵ㡣
 //ظţӷc=a+bôóзأĽҲ浽abС
@@ -14,9 +19,35 @@
 //ڽڵжһvector,varйصӽڵȫעҪָãΪvarпҲͬӽڵ㡣
 
 //varĳʼģڲһnodeȻһnodeָ롣varʼһnodeָ룬ֵ뵽nodeС
+//NoGradGuardɵvarnodenodeptrΪգֱֵӴvarҲټ¼
 
 namespace AD
 {
+	//ڵõġinputconstantֻлļͼ(autodiff_tape.h)
+	enum class Op : unsigned char
+	{
+		leaf = 0,
+		input,
+		constant,
+		add,
+		sub,
+		mul,
+		div,
+		neg,
+		sin,
+		cos,
+		exp,
+		log,
+		pow,
+		op_count
+	};
+
+	template<typename T>
+	class Tape;
+
+	template<typename T>
+	class Jacobian;
+
 	template<typename T>
 	class Var
 	{
@@ -44,6 +75,9 @@ namespace AD
 			//node_ptrӽڵ㣬Tڵӽڵĵ
 			std::vector<std::pair<node_ptr, T>>node_series;		
 
+			//ڵ㣬ӽڵ㰴˳node_series
+			Op op = Op::leaf;
+
 			//򴫲
 			void backward()
 			{
@@ -66,34 +100,69 @@ namespace AD
 			node(T input_value, T input_deriv) :value(input_value), deriv(input_deriv) {};
 		};
 
+		//ʱֵ
+		T plain_value;
+
+		//¼ǰڵӽڵaĵaûnode(NoGradGuardɵĳ)ʱһҶӽڵֵ
+		//ռһڵ㣬ÿĲȫTape¼ʱ԰ɳԭ
+		void link(const Var<T>& a, T partial)
+		{
+			node_ptr p = a.nodeptr;
+			if (!p)
+			{
+				p = std::make_shared<node>(a.get_value());
+				EIGEN1_STAT(stat_var_node, "Var::link(constant)", sizeof(node));
+			}
+			nodeptr->node_series.push_back(std::make_pair(p, partial));
+		}
+
+		friend class Tape<T>;
+		friend class Jacobian<T>;
+
 	public:
 		//װһnodeָ
 		node_ptr nodeptr;
 
 		//ʼ,make_shareһnodeڵ㣬valueΪnode캯
-		Var(T input_value) :nodeptr(std::make_shared<node>(input_value)) {};
+		//رʱnode
+		Var(T input_value) :plain_value(input_value), nodeptr(AD::grad_enabled() ? std::make_shared<node>(input_value) : nullptr)
+		{
+			if (nodeptr)
+			{
+				EIGEN1_STAT(stat_var_node, "Var", sizeof(node));
+			}
+		};
 
 		//ֵ
-		T get_value()
+		T get_value() const
 		{
-			return nodeptr->value;
+			return nodeptr ? nodeptr->value : plain_value;
 		}
 
 		//ص
-		T get_deriv()
+		T get_deriv() const
 		{
-			return nodeptr->deriv;
+			return nodeptr ? nodeptr->deriv : T(0);
 		}
 
 		//趨ݶ
 		void set_deriv(T input_deriv)
 		{
-			nodeptr->deriv = input_deriv;
+			if (nodeptr)
+			{
+				nodeptr->deriv = input_deriv;
+			}
 		}
 
 		//򴫲
 		void backward()
 		{
+			if (!nodeptr)
+			{
+				std::cout << "ڲģʽɵģûмͼ" << std::endl;
+				return;
+			}
+
 			//ӽڵ
 			std::vector<node_ptr>sorted_node;
 
@@ -116,8 +185,12 @@ namespace AD
 		friend Var<T> operator+(Var<T> a, Var<T> b)
 		{
 			Var<T> ends(a.get_value() + b.get_value());
-			ends.nodeptr->node_series.push_back(std::make_pair(a.nodeptr, 1.0));
-			ends.nodeptr->node_series.push_back(std::make_pair(b.nodeptr, 1.0));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::add;
+				ends.link(a, 1.0);
+				ends.link(b, 1.0);
+			}
 			return ends;
 		}
 
@@ -125,8 +198,12 @@ namespace AD
 		friend Var<T> operator-(Var<T> a, Var<T> b)
 		{
 			Var<T> ends(a.get_value() - b.get_value());
-			ends.nodeptr->node_series.push_back(std::make_pair(a.nodeptr, 1.0));
-			ends.nodeptr->node_series.push_back(std::make_pair(b.nodeptr, -1.0));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::sub;
+				ends.link(a, 1.0);
+				ends.link(b, -1.0);
+			}
 			return ends;
 		}
 
@@ -134,8 +211,12 @@ namespace AD
 		friend Var<T> operator*(Var<T> a, Var<T> b)
 		{
 			Var<T> ends(a.get_value() * b.get_value());
-			ends.nodeptr->node_series.push_back(std::make_pair(a.nodeptr, b.nodeptr->value));
-			ends.nodeptr->node_series.push_back(std::make_pair(b.nodeptr, a.nodeptr->value));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::mul;
+				ends.link(a, b.get_value());
+				ends.link(b, a.get_value());
+			}
 			return ends;
 		}
 
@@ -143,8 +224,12 @@ namespace AD
 		friend Var<T> operator/(Var<T> a, Var<T> b)
 		{
 			Var<T> ends(a.get_value() / b.get_value());
-			ends.nodeptr->node_series.push_back(std::make_pair(a.nodeptr, 1.0 / b.nodeptr->value));
-			ends.nodeptr->node_series.push_back(std::make_pair(b.nodeptr, -a.nodeptr->value / (b.nodeptr->value * b.nodeptr->value)));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::div;
+				ends.link(a, 1.0 / b.get_value());
+				ends.link(b, -a.get_value() / (b.get_value() * b.get_value()));
+			}
 			return ends;
 		}
 
@@ -152,31 +237,75 @@ namespace AD
 		friend Var<T> operator-(Var<T> a)
 		{
 			Var<T> ends(-a.get_value());
-			ends.nodeptr->node_series.push_back(std::make_pair(a.nodeptr, -1.0));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::neg;
+				ends.link(a, -1.0);
+			}
+			return ends;
 		}
 
 		//ѧ
 		friend Var<T> sin(Var<T> a)
 		{
 			Var<T>ends(std::sin(a.get_value()));
-			ends.nodeptr->node_series.push_back(std::make_pair(a.nodeptr, std::cos(a.nodeptr->value)));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::sin;
+				ends.link(a, std::cos(a.get_value()));
+			}
 			return ends;
 		}
 
 		friend Var<T> cos(Var<T> a)
 		{
 			Var<T>ends(std::cos(a.get_value()));
-			ends.nodeptr->node_series.push_back(std::make_pair(a.nodeptr, -std::sin(a.nodeptr->value)));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::cos;
+				ends.link(a, -std::sin(a.get_value()));
+			}
+			return ends;
+		}
+
+		friend Var<T> exp(Var<T> a)
+		{
+			Var<T>ends(std::exp(a.get_value()));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::exp;
+				ends.link(a, ends.get_value());
+			}
+			return ends;
+		}
+
+		friend Var<T> log(Var<T> a)
+		{
+			Var<T>ends(std::log(a.get_value()));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::log;
+				ends.link(a, 1.0 / a.get_value());
+			}
+			return ends;
+		}
+
+		friend Var<T> pow(Var<T> a, Var<T> b)
+		{
+			Var<T>ends(std::pow(a.get_value(), b.get_value()));
+			if (ends.nodeptr)
+			{
+				ends.nodeptr->op = Op::pow;
+				ends.link(a, b.get_value() * std::pow(a.get_value(), b.get_value() - 1));
+				ends.link(b, ends.get_value() * std::log(a.get_value()));
+			}
 			return ends;
 		}
-		friend Var<T> exp(Var<T> a);
-		friend Var<T> log(Var<T> a);
-		friend Var<T> pow(Var<T> a, Var<T> b);
 
 		//չʾ
 		void show()
 		{
-			std::cout << "value:" << nodeptr->value << "\t" << "deriv:" << nodeptr->deriv << std::endl;
+			std::cout << "value:" << get_value() << "\t" << "deriv:" << get_deriv() << std::endl;
 		}
 
 	private:
@@ -192,7 +321,7 @@ namespace AD
 				visited.insert(input_node.get());
 			}
 
-			for (std::pair<node_ptr, T>temp : nodeptr->node_series)
+			for (std::pair<node_ptr, T>temp : input_node->node_series)
 			{
 				var_topo_sort(temp.first, sorted_node, visited);
 			}
@@ -214,7 +343,7 @@ namespace AD
 
 			input_node->deriv_zero();
 
-			for (std::pair<node_ptr, T>temp : nodeptr->node_series)
+			for (std::pair<node_ptr, T>temp : input_node->node_series)
 			{
 				var_deriv_zero(temp.first, visited);
 			}
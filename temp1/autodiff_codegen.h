@@ -0,0 +1,248 @@
+#pragma once
+#ifndef _AUTODIFF_CODEGEN_H_
+#define _AUTODIFF_CODEGEN_H_
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+#include "autodiff_tape.h"
+
+//ѴŴC++Դ룺һֱֻߴĺȰ˳ÿڵֵٵۼӰдݶȡ
+//ɵĺڵؽ㣬̶Ŀ꺯ǰʱȥ
+//1.޹صĽڵ㣻
+//2.κĽڵ(ֻɳֵ)İ
+//3.԰ۼӣһдʱֱӶ壬+=
+//ɵĺ磺
+//	inline double name(const double* x, double* grad)
+//x룬gradΪֵgradΪnullptrʱֵֻ
+
+namespace AD
+{
+	namespace detail
+	{
+		template<typename T> struct cpp_type_name;
+		template<> struct cpp_type_name<float> { static const char* get() { return "float"; } };
+		template<> struct cpp_type_name<double> { static const char* get() { return "double"; } };
+		template<> struct cpp_type_name<long double> { static const char* get() { return "long double"; } };
+
+		//дԭص
+		template<typename T>
+		std::string cpp_literal(T v)
+		{
+			std::string type = cpp_type_name<T>::get();
+			if (std::isnan(v))
+			{
+				return "std::numeric_limits<" + type + ">::quiet_NaN()";
+			}
+			if (std::isinf(v))
+			{
+				return std::string(v < 0 ? "-" : "") + "std::numeric_limits<" + type + ">::infinity()";
+			}
+			std::ostringstream out;
+			out << std::setprecision(std::numeric_limits<T>::max_digits10) << v;
+			std::string s = out.str();
+			if (s.find_first_of(".e") == std::string::npos)
+			{
+				s += ".0";
+			}
+			if (type == "float")
+			{
+				s += "f";
+			}
+			else if (type == "long double")
+			{
+				s += "L";
+			}
+			return s;
+		}
+
+		inline std::string node_name(char prefix, int i)
+		{
+			return prefix + std::to_string(i);
+		}
+	}
+
+	//ɼtapeֵݶȵC++Ϊnameʧܷؿַ
+	template<typename T>
+	std::string generate_cpp(const Tape<T>& tape, const std::string& name)
+	{
+		if (!tape.is_valid())
+		{
+			std::cout << "ŴΪգ޷ɴ" << std::endl;
+			return std::string();
+		}
+		int n = tape.node_count();
+		int out_id = tape.output();
+		const TapeOp* ops = tape.get_ops();
+		const T* consts = tape.get_consts();
+		std::string type = detail::cpp_type_name<T>::get();
+
+		//liveĽڵ
+		std::vector<char> live(n, 0);
+		live[out_id] = 1;
+		for (int i = n - 1; i >= 0; i--)
+		{
+			if (live[i] && detail::op_arity((Op)ops[i].op) >= 1)
+			{
+				live[ops[i].a] = 1;
+				if (detail::op_arity((Op)ops[i].op) == 2)
+				{
+					live[ops[i].b] = 1;
+				}
+			}
+		}
+		//activeĳĽڵ㣬ֻЩڵҪ
+		std::vector<char> active(n, 0);
+		for (int i = 0; i < n; i++)
+		{
+			Op op = (Op)ops[i].op;
+			int arity = detail::op_arity(op);
+			active[i] = op == Op::input || (arity >= 1 && active[ops[i].a]) || (arity == 2 && active[ops[i].b]);
+		}
+
+		std::ostringstream code;
+		code << "//AD::TapeɵĴ룺" << n << "ڵ㣬" << tape.input_count() << "\n";
+		code << "inline " << type << " " << name << "(const " << type << "* x, " << type << "* grad)\n{\n";
+
+		//ǰ
+		for (int i = 0; i < n; i++)
+		{
+			if (!live[i])
+			{
+				continue;
+			}
+			const TapeOp& o = ops[i];
+			std::string a = detail::node_name('v', o.a);
+			std::string b = detail::node_name('v', o.b);
+			std::string e;
+			switch ((Op)o.op)
+			{
+			case Op::input: e = "x[" + std::to_string(o.a) + "]"; break;
+			case Op::constant: e = detail::cpp_literal(consts[o.a]); break;
+			case Op::add: e = a + " + " + b; break;
+			case Op::sub: e = a + " - " + b; break;
+			case Op::mul: e = a + " * " + b; break;
+			case Op::div: e = a + " / " + b; break;
+			case Op::neg: e = "-" + a; break;
+			case Op::sin: e = "std::sin(" + a + ")"; break;
+			case Op::cos: e = "std::cos(" + a + ")"; break;
+			case Op::exp: e = "std::exp(" + a + ")"; break;
+			case Op::log: e = "std::log(" + a + ")"; break;
+			case Op::pow: e = "std::pow(" + a + ", " + b + ")"; break;
+			default: e = "0"; break;
+			}
+			code << "\tconst " << type << " v" << i << " = " << e << ";\n";
+		}
+		code << "\tif (grad == nullptr)\n\t{\n\t\treturn v" << out_id << ";\n\t}\n";
+
+		//򣺰һγʱ壬֮ۼ
+		std::vector<char> declared(n, 0);
+		auto accumulate = [&](int j, const std::string& e) {
+			if (!active[j])
+			{
+				return;
+			}
+			if (declared[j])
+			{
+				code << "\ta" << j << " += " << e << ";\n";
+			}
+			else
+			{
+				code << "\t" << type << " a" << j << " = " << e << ";\n";
+				declared[j] = 1;
+			}
+		};
+		if (active[out_id])
+		{
+			code << "\t" << type << " a" << out_id << " = 1;\n";
+			declared[out_id] = 1;
+		}
+		std::vector<std::vector<int>> input_nodes(tape.input_count());
+		for (int i = n - 1; i >= 0; i--)
+		{
+			const TapeOp& o = ops[i];
+			Op op = (Op)o.op;
+			if (op == Op::input)
+			{
+				input_nodes[o.a].push_back(i);
+				continue;
+			}
+			if (!live[i] || !active[i] || !declared[i])
+			{
+				continue;
+			}
+			std::string g = detail::node_name('a', i);
+			std::string va = detail::node_name('v', o.a);
+			std::string vb = detail::node_name('v', o.b);
+			switch (op)
+			{
+			case Op::add: accumulate(o.a, g); accumulate(o.b, g); break;
+			case Op::sub: accumulate(o.a, g); accumulate(o.b, "-" + g); break;
+			case Op::mul: accumulate(o.a, g + " * " + vb); accumulate(o.b, g + " * " + va); break;
+			case Op::div:
+				accumulate(o.a, g + " / " + vb);
+				accumulate(o.b, "-" + g + " * " + va + " / (" + vb + " * " + vb + ")");
+				break;
+			case Op::neg: accumulate(o.a, "-" + g); break;
+			case Op::sin: accumulate(o.a, g + " * std::cos(" + va + ")"); break;
+			case Op::cos: accumulate(o.a, "-" + g + " * std::sin(" + va + ")"); break;
+			case Op::exp: accumulate(o.a, g + " * v" + std::to_string(i)); break;
+			case Op::log: accumulate(o.a, g + " / " + va); break;
+			case Op::pow:
+				accumulate(o.a, g + " * (" + vb + " * std::pow(" + va + ", " + vb + " - 1))");
+				accumulate(o.b, g + " * (v" + std::to_string(i) + " * std::log(" + va + "))");
+				break;
+			default: break;
+			}
+		}
+
+		//дݶ
+		for (std::size_t k = 0; k < input_nodes.size(); k++)
+		{
+			std::string e;
+			for (int i : input_nodes[k])
+			{
+				if (declared[i])
+				{
+					e += e.empty() ? "a" + std::to_string(i) : " + a" + std::to_string(i);
+				}
+			}
+			code << "\tgrad[" << k << "] = " << (e.empty() ? std::string("0") : e) << ";\n";
+		}
+		code << "\treturn v" << out_id << ";\n}\n";
+		return code.str();
+	}
+
+	//ɴ벢дͷļ#pragma onceҪ#includeɹtrue
+	template<typename T>
+	bool write_cpp(const Tape<T>& tape, const std::string& name, const std::string& path)
+	{
+		std::string body = generate_cpp(tape, name);
+		if (body.empty())
+		{
+			return false;
+		}
+		std::FILE* f = Eigen1::detail::open_file(path, "wb");
+		if (f == nullptr)
+		{
+			std::cout << "޷ļ" << path << std::endl;
+			return false;
+		}
+		std::string text = "#pragma once\n\n#include <cmath>\n#include <limits>\n\n" + body;
+		bool good = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+		good = std::fclose(f) == 0 && good;
+		if (!good)
+		{
+			std::cout << "дļʧܣ" << path << std::endl;
+		}
+		return good;
+	}
+}
+
+#endif // !_AUTODIFF_CODEGEN_H_
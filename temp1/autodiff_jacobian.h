@@ -0,0 +1,241 @@
+#pragma once
+#ifndef _AUTODIFF_JACOBIAN_H_
+#define _AUTODIFF_JACOBIAN_H_
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+
+#include "autodiff.h"
+#include "eigen1.h"
+#include "eigen1_memory.h"
+
+//ĳſɱȾ
+//ÿһbackward()Ҫmμͼÿֻһ
+//ÿڵһСΰ(widthȡ4816)һηͬʱwidthӣ
+//õſɱȾwidthУceil(m / width)
+//ͼֻڹʱѹƽһΣɰ˳Ľڵͱ߱(ӽڵšƫ)
+//κĽڵѹƽʱȥˣȫΪ0Ľڵڱʱֱ
+
+namespace AD
+{
+	namespace detail
+	{
+		//adjnode_count x Wİڵ㵹ÿڵİƫӵӽڵ
+		template<typename T, int W>
+		void jacobian_sweep(const std::vector<std::int32_t>& edge_begin, const std::vector<std::int32_t>& edge_child,
+			const std::vector<T>& edge_partial, int n, T* adj)
+		{
+			for (int i = n - 1; i >= 0; i--)
+			{
+				const T* g = adj + (std::size_t)i * W;
+				bool zero = true;
+				for (int k = 0; k < W; k++)
+				{
+					zero = zero && g[k] == T(0);
+				}
+				if (zero)
+				{
+					continue;
+				}
+				for (std::int32_t e = edge_begin[i]; e < edge_begin[i + 1]; e++)
+				{
+					T* c = adj + (std::size_t)edge_child[e] * W;
+					T d = edge_partial[e];
+					for (int k = 0; k < W; k++)
+					{
+						c[k] += d * g[k];
+					}
+				}
+			}
+		}
+	}
+
+	template<typename T>
+	class Jacobian
+	{
+	private:
+		typedef typename Var<T>::node node;
+
+		int n = 0;//ѹƽĽڵ
+		std::vector<std::int32_t> edge_begin;//iڵı[edge_begin[i], edge_begin[i + 1])
+		std::vector<std::int32_t> edge_child;
+		std::vector<T> edge_partial;
+		std::vector<std::int32_t> output_id;//ÿӦĽڵţ-1ʾ޹
+		std::vector<std::int32_t> input_id;//ÿӦĽڵţ-1ʾ޹
+
+		template<int W>
+		void compute_width(Eigen1::Matrix2x<T>& out) const
+		{
+			int m = (int)output_id.size();
+			T* adj = Eigen1::Workspace::local().get<T>(Eigen1::Workspace::ws_tape, (std::size_t)std::max(n, 1) * W);
+			for (int r0 = 0; r0 < m; r0 += W)
+			{
+				int rows = std::min(W, m - r0);
+				std::fill_n(adj, (std::size_t)n * W, T(0));
+				for (int k = 0; k < rows; k++)
+				{
+					if (output_id[r0 + k] >= 0)
+					{
+						adj[(std::size_t)output_id[r0 + k] * W + k] += T(1);
+					}
+				}
+				detail::jacobian_sweep<T, W>(edge_begin, edge_child, edge_partial, n, adj);
+				for (int k = 0; k < rows; k++)
+				{
+					T* p = out[r0 + k];
+					for (int j = 0; j < out.get_col(); j++)
+					{
+						p[j] = input_id[j] >= 0 ? adj[(std::size_t)input_id[j] * W + k] : T(0);
+					}
+				}
+			}
+		}
+
+	public:
+		//ѹƽoutputsͬļͼֻߵinputsĲ
+		Jacobian(const std::vector<Var<T>>& outputs, const std::vector<Var<T>>& inputs)
+		{
+			std::unordered_map<const node*, std::int32_t> index;
+			std::vector<const node*> order;
+			std::vector<std::pair<const node*, std::size_t>> stack;
+			//ǵݹȱӽڵڸڵǰ
+			for (const Var<T>& y : outputs)
+			{
+				if (!y.nodeptr || !index.insert(std::make_pair(y.nodeptr.get(), -1)).second)
+				{
+					continue;
+				}
+				stack.push_back(std::make_pair(y.nodeptr.get(), std::size_t(0)));
+				while (!stack.empty())
+				{
+					const node* p = stack.back().first;
+					std::size_t& k = stack.back().second;
+					if (k < p->node_series.size())
+					{
+						const node* c = p->node_series[k].first.get();
+						k++;
+						if (index.insert(std::make_pair(c, -1)).second)
+						{
+							stack.push_back(std::make_pair(c, std::size_t(0)));
+						}
+						continue;
+					}
+					index[p] = (std::int32_t)order.size();
+					order.push_back(p);
+					stack.pop_back();
+				}
+			}
+
+			//activeߵĳĽڵ
+			std::vector<char> active(order.size(), 0);
+			for (const Var<T>& x : inputs)
+			{
+				auto it = x.nodeptr ? index.find(x.nodeptr.get()) : index.end();
+				if (it != index.end())
+				{
+					active[it->second] = 1;
+				}
+			}
+			for (std::size_t i = 0; i < order.size(); i++)
+			{
+				for (const auto& c : order[i]->node_series)
+				{
+					active[i] = active[i] || active[index[c.first.get()]];
+				}
+			}
+
+			//±ţֻactiveĽڵָactiveӽڵı
+			std::vector<std::int32_t> remap(order.size(), -1);
+			for (std::size_t i = 0; i < order.size(); i++)
+			{
+				if (active[i])
+				{
+					remap[i] = n++;
+				}
+			}
+			edge_begin.reserve(n + 1);
+			for (std::size_t i = 0; i < order.size(); i++)
+			{
+				if (!active[i])
+				{
+					continue;
+				}
+				edge_begin.push_back((std::int32_t)edge_child.size());
+				for (const auto& c : order[i]->node_series)
+				{
+					std::int32_t j = remap[index[c.first.get()]];
+					if (j >= 0)
+					{
+						edge_child.push_back(j);
+						edge_partial.push_back(c.second);
+					}
+				}
+			}
+			edge_begin.push_back((std::int32_t)edge_child.size());
+
+			for (const Var<T>& y : outputs)
+			{
+				output_id.push_back(y.nodeptr ? remap[index[y.nodeptr.get()]] : -1);
+			}
+			for (const Var<T>& x : inputs)
+			{
+				auto it = x.nodeptr ? index.find(x.nodeptr.get()) : index.end();
+				input_id.push_back(it != index.end() ? remap[it->second] : -1);
+			}
+		}
+
+		//
+		int get_row() const
+		{
+			return (int)output_id.size();
+		}
+
+		//
+		int get_col() const
+		{
+			return (int)input_id.size();
+		}
+
+		//ѹƽĽڵ
+		int node_count() const
+		{
+			return n;
+		}
+
+		//out(i, j) = d outputs[i] / d inputs[j]widthÿηȡ4816
+		void compute(Eigen1::Matrix2x<T>& out, int width = 8) const
+		{
+			if (out.get_row() != get_row() || out.get_col() != get_col())
+			{
+				out.resize(get_row(), get_col());
+			}
+			if (width <= 4)
+			{
+				compute_width<4>(out);
+			}
+			else if (width <= 8)
+			{
+				compute_width<8>(out);
+			}
+			else
+			{
+				compute_width<16>(out);
+			}
+		}
+	};
+
+	//outputsinputsſɱȾ( x )
+	template<typename T>
+	Eigen1::Matrix2x<T> jacobian(const std::vector<Var<T>>& outputs, const std::vector<Var<T>>& inputs, int width = 8)
+	{
+		Eigen1::Matrix2x<T>ends;
+		Jacobian<T>(outputs, inputs).compute(ends, width);
+		return ends;
+	}
+}
+
+#endif // !_AUTODIFF_JACOBIAN_H_
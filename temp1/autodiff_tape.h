@@ -0,0 +1,531 @@
+#pragma once
+#ifndef _AUTODIFF_TAPE_H_
+#define _AUTODIFF_TAPE_H_
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <iostream>
+
+#include "autodiff.h"
+#include "eigen1_memory.h"
+#include "eigen1_io.h"
+
+//ͼлAD::Varͼһshared_ptrڵ㣬ֻڵǰ
+//Tape˳ѹƽһ"Ŵ"ÿڵһ¼(㡢ı)ټһų
+//ŴڴĲֺļȫһ
+//	64ֽļͷ | node_countTapeOp(ÿ12ֽ) | 뵽64ֽ | const_count
+//дʱдʱֱmmapļһļͷ͸¼ֵΪڵκڴ档
+//ֵʱڵֵڵ߸(ǰ̵߳Workspace)Իһ뷴ֵݶȡ
+
+namespace AD
+{
+	//Ŵļͷ̶64ֽڣС
+	struct TapeFileHeader
+	{
+		char magic[8];//"ADTAPE"
+		std::uint32_t version;
+		std::uint32_t dtype;//ͣͬEigen1::matrix_dtype
+		std::int64_t node_count;//ڵ
+		std::int64_t input_count;//
+		std::int64_t const_count;//
+		std::int64_t output;//ڵı
+		std::uint64_t ops_offset;//ڵ¼ӵڼֽڿʼ
+		std::uint64_t consts_offset;//ӵڼֽڿʼ
+	};
+	static_assert(sizeof(TapeFileHeader) == 64, "TapeFileHeader64ֽ");
+
+	//Ŵϵһڵ㡣inputaıţconstantaǳıţ
+	//abǲڵı(һԪbΪ-1)ڵǰڵǰ
+	struct TapeOp
+	{
+		std::uint32_t op;
+		std::int32_t a;
+		std::int32_t b;
+	};
+	static_assert(sizeof(TapeOp) == 12, "TapeOp12ֽ");
+
+	namespace detail
+	{
+		const char tape_magic[8] = { 'A', 'D', 'T', 'A', 'P', 'E', '\0', '\0' };
+		const std::uint32_t tape_version = 1;
+
+		//Ĳ
+		inline int op_arity(Op op)
+		{
+			switch (op)
+			{
+			case Op::add:
+			case Op::sub:
+			case Op::mul:
+			case Op::div:
+			case Op::pow:
+				return 2;
+			case Op::neg:
+			case Op::sin:
+			case Op::cos:
+			case Op::exp:
+			case Op::log:
+				return 1;
+			default:
+				return 0;
+			}
+		}
+
+		inline std::uint64_t align_up(std::uint64_t n, std::uint64_t a)
+		{
+			return (n + a - 1) / a * a;
+		}
+	}
+
+	template<typename T>
+	class Tape
+	{
+	private:
+		typedef typename Var<T>::node node;
+
+		Eigen1::aligned_vector<char> buffer;//recordõĴŴ
+		Eigen1::MappedFile file;//loadӳĴŴ
+
+		const char* base = nullptr;
+		std::size_t length = 0;
+		const TapeFileHeader* head = nullptr;
+		const TapeOp* ops = nullptr;
+		const T* consts = nullptr;
+
+		void clear()
+		{
+			file.close();
+			Eigen1::aligned_vector<char>().swap(buffer);
+			base = nullptr;
+			length = 0;
+			head = nullptr;
+			ops = nullptr;
+			consts = nullptr;
+		}
+
+		void take(Tape& a)
+		{
+			buffer = std::move(a.buffer);
+			file = std::move(a.file);
+			base = a.base;
+			length = a.length;
+			head = a.head;
+			ops = a.ops;
+			consts = a.consts;
+			a.base = nullptr;
+			a.length = 0;
+			a.head = nullptr;
+			a.ops = nullptr;
+			a.consts = nullptr;
+		}
+
+		//pʼlengthֽǲĴŴǵĻָָȥ
+		bool attach(const char* p, std::size_t n)
+		{
+			if (n < sizeof(TapeFileHeader))
+			{
+				std::cout << "ŴļȲ㣬ݲ" << std::endl;
+				return false;
+			}
+			const TapeFileHeader* h = reinterpret_cast<const TapeFileHeader*>(p);
+			if (std::memcmp(h->magic, detail::tape_magic, 8) != 0 || h->version != detail::tape_version)
+			{
+				std::cout << "ǼͼŴļ汾֧" << std::endl;
+				return false;
+			}
+			if ((int)h->dtype != Eigen1::dtype_of<T>::value)
+			{
+				std::cout << "ŴļȡͲһ" << std::endl;
+				return false;
+			}
+			//ȼȱ֤ƫļȣٺʣµĳȱȣΪƶŹļ
+			if (h->node_count <= 0 || h->node_count > INT32_MAX || h->input_count < 0 || h->input_count > INT32_MAX
+				|| h->const_count < 0 || h->const_count > INT32_MAX || h->output < 0 || h->output >= h->node_count
+				|| h->ops_offset < sizeof(TapeFileHeader) || h->ops_offset % alignof(TapeOp) != 0
+				|| h->consts_offset < sizeof(TapeFileHeader) || h->consts_offset % alignof(T) != 0
+				|| h->ops_offset > n || (std::uint64_t)h->node_count * sizeof(TapeOp) > n - h->ops_offset
+				|| h->consts_offset > n || (std::uint64_t)h->const_count * sizeof(T) > n - h->consts_offset)
+			{
+				std::cout << "Ŵļͷ" << std::endl;
+				return false;
+			}
+			const TapeOp* o = reinterpret_cast<const TapeOp*>(p + h->ops_offset);
+			//飬ֵ֤ʱ±궼Խ
+			for (std::int32_t i = 0; i < (std::int32_t)h->node_count; i++)
+			{
+				bool good;
+				Op op = (Op)o[i].op;
+				if (o[i].op >= (std::uint32_t)Op::op_count)
+				{
+					good = false;
+				}
+				else if (op == Op::input)
+				{
+					good = o[i].a >= 0 && o[i].a < h->input_count;
+				}
+				else if (op == Op::constant)
+				{
+					good = o[i].a >= 0 && o[i].a < h->const_count;
+				}
+				else if (detail::op_arity(op) == 2)
+				{
+					good = o[i].a >= 0 && o[i].a < i && o[i].b >= 0 && o[i].b < i;
+				}
+				else
+				{
+					good = detail::op_arity(op) == 1 && o[i].a >= 0 && o[i].a < i;
+				}
+				if (!good)
+				{
+					std::cout << "Ŵĵ" << i << "ڵ" << std::endl;
+					return false;
+				}
+			}
+			base = p;
+			length = n;
+			head = h;
+			ops = o;
+			consts = reinterpret_cast<const T*>(p + h->consts_offset);
+			return true;
+		}
+
+	public:
+		//ĬϳʼմŴ
+		Tape() {};
+
+		//¼outputΪյļͼ
+		Tape(const Var<T>& output, const std::vector<Var<T>>& inputs)
+		{
+			record(output, inputs);
+		}
+
+		Tape(const Tape&) = delete;
+		Tape& operator =(const Tape&) = delete;
+
+		Tape(Tape&& a) noexcept
+		{
+			take(a);
+		}
+
+		Tape& operator =(Tape&& a) noexcept
+		{
+			if (this != &a)
+			{
+				clear();
+				take(a);
+			}
+			return *this;
+		}
+
+		//outputļͼѹƽɴŴinputsı˳Ϊ012...룬ظ
+		//Ҷӽڵ(NoGradGuardĲ)ΪµǰֵinputsҲԷмʱ֮ǰļ㱻ضϣ롣
+		//ɹtrue
+		bool record(const Var<T>& output, const std::vector<Var<T>>& inputs)
+		{
+			clear();
+			if (!output.nodeptr)
+			{
+				std::cout << "ڲģʽɵģûмͼԼ¼" << std::endl;
+				return false;
+			}
+			std::unordered_map<const node*, std::int32_t> input_id;
+			for (std::size_t k = 0; k < inputs.size(); k++)
+			{
+				if (!inputs[k].nodeptr)
+				{
+					std::cout << "" << k << "ûмͼڵ" << std::endl;
+					return false;
+				}
+				//ͬһռλʱŴֻһinputڵ㣬ݶֻдһλãֱӾܾ
+				auto in = input_id.insert(std::make_pair(inputs[k].nodeptr.get(), (std::int32_t)k));
+				if (!in.second)
+				{
+					std::cout << "" << k << "͵" << in.first->second << "ͬһ޷¼" << std::endl;
+					return false;
+				}
+			}
+
+			//ǵݹȱõ˳
+			std::vector<const node*> order;
+			std::unordered_map<const node*, std::int32_t> index;
+			std::vector<std::pair<const node*, std::size_t>> stack;
+			stack.push_back(std::make_pair(output.nodeptr.get(), std::size_t(0)));
+			index.insert(std::make_pair(output.nodeptr.get(), -1));
+			while (!stack.empty())
+			{
+				const node* p = stack.back().first;
+				std::size_t& k = stack.back().second;
+				bool cut = input_id.count(p) != 0;
+				if (!cut && k < p->node_series.size())
+				{
+					const node* c = p->node_series[k].first.get();
+					k++;
+					if (index.insert(std::make_pair(c, -1)).second)
+					{
+						stack.push_back(std::make_pair(c, std::size_t(0)));
+					}
+					continue;
+				}
+				index[p] = (std::int32_t)order.size();
+				order.push_back(p);
+				stack.pop_back();
+			}
+
+			std::size_t const_count = 0;
+			for (const node* p : order)
+			{
+				if (input_id.count(p) == 0 && p->node_series.empty())
+				{
+					const_count++;
+				}
+			}
+			std::uint64_t ops_offset = sizeof(TapeFileHeader);
+			std::uint64_t consts_offset = detail::align_up(ops_offset + order.size() * sizeof(TapeOp), 64);
+			buffer.assign((std::size_t)(consts_offset + const_count * sizeof(T)), 0);
+
+			TapeFileHeader* h = reinterpret_cast<TapeFileHeader*>(buffer.data());
+			std::memcpy(h->magic, detail::tape_magic, 8);
+			h->version = detail::tape_version;
+			h->dtype = Eigen1::dtype_of<T>::value;
+			h->node_count = (std::int64_t)order.size();
+			h->input_count = (std::int64_t)inputs.size();
+			h->const_count = (std::int64_t)const_count;
+			h->output = (std::int64_t)order.size() - 1;
+			h->ops_offset = ops_offset;
+			h->consts_offset = consts_offset;
+
+			TapeOp* o = reinterpret_cast<TapeOp*>(buffer.data() + ops_offset);
+			T* c = reinterpret_cast<T*>(buffer.data() + consts_offset);
+			std::int32_t nc = 0;
+			for (std::size_t i = 0; i < order.size(); i++)
+			{
+				const node* p = order[i];
+				auto in = input_id.find(p);
+				o[i].b = -1;
+				if (in != input_id.end())
+				{
+					o[i].op = (std::uint32_t)Op::input;
+					o[i].a = in->second;
+				}
+				else if (p->node_series.empty())
+				{
+					o[i].op = (std::uint32_t)Op::constant;
+					o[i].a = nc;
+					c[nc++] = p->value;
+				}
+				else
+				{
+					int arity = detail::op_arity(p->op);
+					if (arity == 0 || (std::size_t)arity != p->node_series.size())
+					{
+						//Բ(صɵĽڵ)޷ԭ
+						std::cout << "ͼвĽڵ㣬޷¼" << std::endl;
+						clear();
+						return false;
+					}
+					o[i].op = (std::uint32_t)p->op;
+					o[i].a = index[p->node_series[0].first.get()];
+					if (arity == 2)
+					{
+						o[i].b = index[p->node_series[1].first.get()];
+					}
+				}
+			}
+			return attach(buffer.data(), buffer.size());
+		}
+
+		//дļɹtrue
+		bool save(const std::string& path) const
+		{
+			if (!is_valid())
+			{
+				std::cout << "ŴΪգûпд" << std::endl;
+				return false;
+			}
+			std::FILE* f = Eigen1::detail::open_file(path, "wb");
+			if (f == nullptr)
+			{
+				std::cout << "޷ļ" << path << std::endl;
+				return false;
+			}
+			bool good = std::fwrite(base, 1, length, f) == length;
+			good = std::fclose(f) == 0 && good;
+			if (!good)
+			{
+				std::cout << "дļʧܣ" << path << std::endl;
+			}
+			return good;
+		}
+
+		//mmapŴļɹtrueݣҲΪڵڴ
+		bool load(const std::string& path)
+		{
+			clear();
+			if (!file.open(path, sizeof(TapeFileHeader)))
+			{
+				return false;
+			}
+			if (!attach(static_cast<const char*>(file.data()), file.size()))
+			{
+				clear();
+				return false;
+			}
+			return true;
+		}
+
+		//ǷпõĴŴ
+		bool is_valid() const
+		{
+			return head != nullptr;
+		}
+
+		//ڵ
+		int node_count() const
+		{
+			return head ? (int)head->node_count : 0;
+		}
+
+		//
+		int input_count() const
+		{
+			return head ? (int)head->input_count : 0;
+		}
+
+		//
+		int const_count() const
+		{
+			return head ? (int)head->const_count : 0;
+		}
+
+		//ڵı
+		int output() const
+		{
+			return head ? (int)head->output : -1;
+		}
+
+		//ڵ¼
+		const TapeOp* get_ops() const
+		{
+			return ops;
+		}
+
+		//
+		const T* get_consts() const
+		{
+			return consts;
+		}
+
+		//Ŵֽ(ļСͬ)
+		std::size_t bytes() const
+		{
+			return length;
+		}
+
+		//ǰֵx룬valuesnode_countÿڵֵֵ
+		T forward(const T* x, T* values) const
+		{
+			if (!is_valid())
+			{
+				std::cout << "ŴΪգ޷ֵ" << std::endl;
+				return T(0);
+			}
+			int n = node_count();
+			for (int i = 0; i < n; i++)
+			{
+				const TapeOp& o = ops[i];
+				T v;
+				switch ((Op)o.op)
+				{
+				case Op::input: v = x[o.a]; break;
+				case Op::constant: v = consts[o.a]; break;
+				case Op::add: v = values[o.a] + values[o.b]; break;
+				case Op::sub: v = values[o.a] - values[o.b]; break;
+				case Op::mul: v = values[o.a] * values[o.b]; break;
+				case Op::div: v = values[o.a] / values[o.b]; break;
+				case Op::neg: v = -values[o.a]; break;
+				case Op::sin: v = std::sin(values[o.a]); break;
+				case Op::cos: v = std::cos(values[o.a]); break;
+				case Op::exp: v = std::exp(values[o.a]); break;
+				case Op::log: v = std::log(values[o.a]); break;
+				case Op::pow: v = std::pow(values[o.a], values[o.b]); break;
+				default: v = T(0); break;
+				}
+				values[i] = v;
+			}
+			return values[head->output];
+		}
+
+		//ǰֵڵֵڵǰ̵߳Workspace
+		T forward(const T* x) const
+		{
+			T* values = Eigen1::Workspace::local().get<T>(Eigen1::Workspace::ws_tape, (std::size_t)node_count());
+			return forward(x, values);
+		}
+
+		//򴫲valuesforwardõĽڵֵadjointnode_countgradÿĵ
+		//ƫĹʽVarĸһ
+		void backward(const T* values, T* adjoint, T* grad) const
+		{
+			if (!is_valid())
+			{
+				std::cout << "ŴΪգ޷" << std::endl;
+				return;
+			}
+			int n = node_count();
+			std::fill_n(adjoint, n, T(0));
+			std::fill_n(grad, input_count(), T(0));
+			adjoint[head->output] = T(1);
+			for (int i = n - 1; i >= 0; i--)
+			{
+				const TapeOp& o = ops[i];
+				T g = adjoint[i];
+				switch ((Op)o.op)
+				{
+				case Op::input: grad[o.a] += g; break;
+				case Op::constant: break;
+				case Op::add: adjoint[o.a] += g; adjoint[o.b] += g; break;
+				case Op::sub: adjoint[o.a] += g; adjoint[o.b] -= g; break;
+				case Op::mul: adjoint[o.a] += g * values[o.b]; adjoint[o.b] += g * values[o.a]; break;
+				case Op::div:
+					adjoint[o.a] += g * (T(1) / values[o.b]);
+					adjoint[o.b] += g * (-values[o.a] / (values[o.b] * values[o.b]));
+					break;
+				case Op::neg: adjoint[o.a] -= g; break;
+				case Op::sin: adjoint[o.a] += g * std::cos(values[o.a]); break;
+				case Op::cos: adjoint[o.a] += g * -std::sin(values[o.a]); break;
+				case Op::exp: adjoint[o.a] += g * values[i]; break;
+				case Op::log: adjoint[o.a] += g * (T(1) / values[o.a]); break;
+				case Op::pow:
+					adjoint[o.a] += g * (values[o.b] * std::pow(values[o.a], values[o.b] - 1));
+					adjoint[o.b] += g * (values[i] * std::log(values[o.a]));
+					break;
+				default: break;
+				}
+			}
+		}
+
+		//ֵݶȣgradΪinput_countֵ
+		T gradient(const T* x, T* grad, T* values, T* adjoint) const
+		{
+			T ends = forward(x, values);
+			backward(values, adjoint, grad);
+			return ends;
+		}
+
+		//ֵݶȣмڵǰ̵߳Workspaceòڴ
+		T gradient(const T* x, T* grad) const
+		{
+			std::size_t n = (std::size_t)node_count();
+			T* values = Eigen1::Workspace::local().get<T>(Eigen1::Workspace::ws_tape, 2 * n);
+			return gradient(x, grad, values, values + n);
+		}
+	};
+}
+
+#endif // !_AUTODIFF_TAPE_H_
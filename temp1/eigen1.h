@@ -4,25 +4,265 @@
 
 #include <vector>
 #include <iostream>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+#include "eigen1_memory.h"
+#include "eigen1_stats.h"
+#include "eigen1_parallel.h"
 
 namespace Eigen1
 {
+	namespace detail
+	{
+		//ֿ˷Ĳcmr x nrСڼĴamc x kcbkc x ncֿ
+		const int gemm_mr = 4;
+		const int gemm_nr = 8;
+		const int gemm_mc = 64;
+		const int gemm_kc = 256;
+		const int gemm_nc = 2048;
+
+		//˼Ӵʱֱѭ
+		const long long gemm_small = 32 * 32 * 32;
+
+		//op(a)[i0, i0+mc) x [k0, k0+kc)mrеĺÿڰkkmrԪmrеĲ0
+		//תþﴦtransʱop(a)(i, k) = a[k][i]ҪȰaתó
+		template<typename T>
+		void gemm_pack_a(const T* a, int lda, bool trans, int i0, int k0, int mc, int kc, T* buf)
+		{
+			for (int ir = 0; ir < mc; ir += gemm_mr)
+			{
+				int rows = std::min(gemm_mr, mc - ir);
+				T* dst = buf + (std::size_t)ir * kc;
+				for (int k = 0; k < kc; k++)
+				{
+					for (int r = 0; r < gemm_mr; r++)
+					{
+						int i = i0 + ir + r;
+						dst[k * gemm_mr + r] = r >= rows ? T(0) : (trans ? a[(std::size_t)(k0 + k) * lda + i] : a[(std::size_t)i * lda + k0 + k]);
+					}
+				}
+			}
+		}
+
+		//op(b)[k0, k0+kc) x [j0, j0+nc)nrеtransʱop(b)(k, j) = b[j][k]
+		template<typename T>
+		void gemm_pack_b(const T* b, int ldb, bool trans, int k0, int j0, int kc, int nc, T* buf)
+		{
+			for (int jr = 0; jr < nc; jr += gemm_nr)
+			{
+				int cols = std::min(gemm_nr, nc - jr);
+				T* dst = buf + (std::size_t)jr * kc;
+				for (int k = 0; k < kc; k++)
+				{
+					for (int q = 0; q < gemm_nr; q++)
+					{
+						int j = j0 + jr + q;
+						dst[k * gemm_nr + q] = q >= cols ? T(0) : (trans ? b[(std::size_t)j * ldb + k0 + k] : b[(std::size_t)(k0 + k) * ldb + j]);
+					}
+				}
+			}
+		}
+
+		//cһmr x nrС += alpha * (a * b)
+		template<typename T>
+		void gemm_micro(int kc, const T* pa, const T* pb, T alpha, T* c, int ldc, int rows, int cols)
+		{
+			T acc[gemm_mr][gemm_nr] = {};
+			for (int k = 0; k < kc; k++)
+			{
+				const T* a = pa + k * gemm_mr;
+				const T* b = pb + k * gemm_nr;
+				for (int r = 0; r < gemm_mr; r++)
+				{
+					T av = a[r];
+					for (int q = 0; q < gemm_nr; q++)
+					{
+						acc[r][q] += av * b[q];
+					}
+				}
+			}
+			for (int r = 0; r < rows; r++)
+			{
+				T* pc = c + (std::size_t)r * ldc;
+				for (int q = 0; q < cols; q++)
+				{
+					pc[q] += alpha * acc[r][q];
+				}
+			}
+		}
+
+		//βepilogue
+		struct gemm_no_epilogue
+		{
+			template<typename T>
+			void operator ()(int, int, T*, int) const {};
+		};
+
+		//c(m x nоldc) = alpha * op(a) * op(b) + beta * cop(a)m x kop(b)k x n
+		//cÿһ(һkҲ)֮ϵepi(i, j, p, len)pָc(i, j)lenԪأ
+		//ʱνL1ƫá֮βٰcڴһ
+		//ʱepiڶ߳ԲཻcͬʱãܸĹ״̬
+		template<typename T, typename Epi>
+		void gemm_kernel(bool trans_a, bool trans_b, int m, int n, int k, T alpha, const T* a, int lda, const T* b, int ldb, T beta, T* c, int ldc, Epi epi)
+		{
+			for (int i = 0; i < m; i++)
+			{
+				T* pc = c + (std::size_t)i * ldc;
+				if (beta == T(0))
+				{
+					std::fill_n(pc, n, T(0));
+				}
+				else if (beta != T(1))
+				{
+					for (int j = 0; j < n; j++)
+					{
+						pc[j] *= beta;
+					}
+				}
+			}
+			if (alpha == T(0) || k == 0)
+			{
+				for (int i = 0; i < m; i++)
+				{
+					epi(i, 0, c + (std::size_t)i * ldc, n);
+				}
+				return;
+			}
+			if ((long long)m * n * k < gemm_small)
+			{
+				for (int i = 0; i < m; i++)
+				{
+					T* pc = c + (std::size_t)i * ldc;
+					for (int p = 0; p < k; p++)
+					{
+						T temp = alpha * (trans_a ? a[(std::size_t)p * lda + i] : a[(std::size_t)i * lda + p]);
+						if (trans_b)
+						{
+							for (int j = 0; j < n; j++)
+							{
+								pc[j] += temp * b[(std::size_t)j * ldb + p];
+							}
+						}
+						else
+						{
+							const T* pb = b + (std::size_t)p * ldb;
+							for (int j = 0; j < n; j++)
+							{
+								pc[j] += temp * pb[j];
+							}
+						}
+					}
+					epi(i, 0, pc, n);
+				}
+				return;
+			}
+			for (int jc = 0; jc < n; jc += gemm_nc)
+			{
+				int nc = std::min(gemm_nc, n - jc);
+				for (int pc = 0; pc < k; pc += gemm_kc)
+				{
+					int kc = std::min(gemm_kc, k - pc);
+					bool last = pc + kc == k;
+					//bĴ̹߳ãڵ̵߳Ĺ
+					std::size_t nb = (std::size_t)(nc + gemm_nr - 1) / gemm_nr * gemm_nr * kc;
+					T* pb = Workspace::local().get<T>(Workspace::ws_gemm_b, nb);
+					gemm_pack_b(b, ldb, trans_b, pc, jc, kc, nc, pb);
+					//aпָ̣߳ÿ̰߳ԼaԼĹ
+					parallel_for(0, (m + gemm_mc - 1) / gemm_mc, 1, [&](long long lo, long long hi) {
+						T* pa = Workspace::local().get<T>(Workspace::ws_gemm_a, (std::size_t)(gemm_mc + gemm_mr) * kc);
+						for (long long blk = lo; blk < hi; blk++)
+						{
+							int ic = (int)blk * gemm_mc;
+							int mc = std::min(gemm_mc, m - ic);
+							gemm_pack_a(a, lda, trans_a, ic, pc, mc, kc, pa);
+							for (int jr = 0; jr < nc; jr += gemm_nr)
+							{
+								for (int ir = 0; ir < mc; ir += gemm_mr)
+								{
+									int rows = std::min(gemm_mr, mc - ir);
+									int cols = std::min(gemm_nr, nc - jr);
+									T* pc0 = c + (std::size_t)(ic + ir) * ldc + jc + jr;
+									gemm_micro(kc, pa + (std::size_t)ir * kc, pb + (std::size_t)jr * kc, alpha, pc0, ldc, rows, cols);
+									if (last)
+									{
+										for (int r = 0; r < rows; r++)
+										{
+											epi(ic + ir + r, jc + jr, pc0 + (std::size_t)r * ldc, cols);
+										}
+									}
+								}
+							}
+						}
+					});
+				}
+			}
+		}
+
+		template<typename T>
+		void gemm_kernel(bool trans_a, bool trans_b, int m, int n, int k, T alpha, const T* a, int lda, const T* b, int ldb, T beta, T* c, int ldc)
+		{
+			gemm_kernel(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, gemm_no_epilogue());
+		}
+	}
+
 	template<typename T>
 	class Matrix2x
 	{
 	private:
 		int row;//
 		int col;//
-		std::vector<std::vector<T>> data;
+		T* data;//洢row*colԪأ64ֽڶ룬ڴ߳ڴ
+		bool owner = true;//Ϊfalseʱdataָⲿڴ(map)ʱͷ
 
 		double zero_rate = 0.000001;//̫СΪ0
 
+		//row*colԪصڴ
+		void allocate()
+		{
+			std::size_t n = (std::size_t)this->row * this->col;
+			this->data = n == 0 ? nullptr : static_cast<T*>(pool_allocate(n * sizeof(T)));
+			this->owner = true;
+			if (n != 0)
+			{
+				EIGEN1_STAT(stat_matrix_alloc, "Matrix2x", n * sizeof(T));
+			}
+		}
+
+		//ڴ滹ڴ
+		void deallocate()
+		{
+			if (this->owner)
+			{
+				pool_deallocate(this->data, (std::size_t)this->row * this->col * sizeof(T));
+			}
+			this->data = nullptr;
+			this->owner = true;
+		}
+
+		//ȫ
+		void fill_zero()
+		{
+			std::fill_n(this->data, (std::size_t)this->row * this->col, T(0));
+		}
+
+		//±ԽʱصУǰ̵߳һ0(colԪ)0дȥֱֵӶ
+		//õõָ룬ÿָ
+		T* spare_row() const
+		{
+			static thread_local std::vector<T> spare;
+			spare.assign(this->col > 0 ? this->col : 1, T(0));
+			return spare.data();
+		}
+
 	public:
 		//Ĭϳʼ
 		Matrix2x()
 		{
 			this->row = 0;
 			this->col = 0;
+			this->data = nullptr;
 		}
 
 		//гʼ
@@ -30,18 +270,92 @@ namespace Eigen1
 		{
 			this->row = size_row;
 			this->col = size_col;
-			for (int i = 0; i < row; i++)
-			{
-				data.push_back(std::vector<T>(this->col, 0));
-			}
+			allocate();
+			fill_zero();
 		}
 
 		//캯
 		Matrix2x(const Matrix2x<T>& a)
+		{
+			this->row = a.row;
+			this->col = a.col;
+			allocate();
+			std::copy_n(a.data, (std::size_t)a.row * a.col, this->data);
+			EIGEN1_STAT(stat_matrix_copy, "copy constructor", a.size() * sizeof(T));
+		}
+
+		//ƶ캯ֱӽӹaݣaΪվ
+		Matrix2x(Matrix2x<T>&& a) noexcept
 		{
 			this->row = a.row;
 			this->col = a.col;
 			this->data = a.data;
+			this->owner = a.owner;
+			a.row = 0;
+			a.col = 0;
+			a.data = nullptr;
+			a.owner = true;
+		}
+
+		//ڴ滹ڴ
+		~Matrix2x()
+		{
+			deallocate();
+		}
+
+		//ֵ״ͬʱֱӸԭڴ
+		Matrix2x<T>& operator =(const Matrix2x<T>& a)
+		{
+			if (this != &a)
+			{
+				if (this->row != a.row || this->col != a.col)
+				{
+					deallocate();
+					this->row = a.row;
+					this->col = a.col;
+					allocate();
+				}
+				std::copy_n(a.data, (std::size_t)a.row * a.col, this->data);
+				EIGEN1_STAT(stat_matrix_copy, "copy assignment", a.size() * sizeof(T));
+			}
+			return *this;
+		}
+
+		//ƶֵ
+		Matrix2x<T>& operator =(Matrix2x<T>&& a) noexcept
+		{
+			if (this != &a)
+			{
+				deallocate();
+				this->row = a.row;
+				this->col = a.col;
+				this->data = a.data;
+				this->owner = a.owner;
+				a.row = 0;
+				a.col = 0;
+				a.data = nullptr;
+				a.owner = true;
+			}
+			return *this;
+		}
+
+		//ⲿһڴ(row*colԪأд洢)ɾʹãҲͷš
+		//öһⲿڴȷصľþá
+		//ֵ(״ͬ)ֱдⲿڴ棻resizeɱĴСͨ
+		static Matrix2x<T> map(T* p, int size_row, int size_col)
+		{
+			Matrix2x<T>ends;
+			ends.row = size_row;
+			ends.col = size_col;
+			ends.data = p;
+			ends.owner = false;
+			return ends;
+		}
+
+		//ǷԼ
+		bool is_owner() const
+		{
+			return this->owner;
 		}
 
 		//ֵΪķ
@@ -49,10 +363,8 @@ namespace Eigen1
 		{
 			this->row = n;
 			this->col = n;
-			for (int i = 0; i < this->row; i++)
-			{
-				data.push_back(std::vector<T>(this->col, 0));
-			}
+			allocate();
+			fill_zero();
 		}
 
 		//ڷ쵥λ
@@ -60,15 +372,13 @@ namespace Eigen1
 		{
 			this->row = n;
 			this->col = n;
-			for (int i = 0; i < this->row; i++)
-			{
-				data.push_back(std::vector<T>(this->col, 0));
-			}
+			allocate();
+			fill_zero();
 			if (c == 'I')
 			{
 				for (int i = 0; i < n; i++)
 				{
-					data[i][i] = 1;
+					this->data[i * n + i] = 1;
 				}
 			}
 			else
@@ -77,77 +387,221 @@ namespace Eigen1
 			}
 		}
 
-		//[]
-		std::vector<T>& operator [](int row)
+		//[]صrowеָ룬m[i][j]÷䣻Խʱʾ
+		T* operator [](int row)
 		{
-			if (row > this->row)
+			if (row < 0 || row >= this->row)
 			{
 				std::cout << "±곬" << std::endl;
-				std::vector<T>temp(this->row, 0);
-				return temp;
+				return spare_row();
 			}
 			else
 			{
-				return this->data[row];
+				return this->data + (std::size_t)row * this->col;
 			}
 		}
-		const std::vector<T> operator [](int row)const
+		//const汾ָֻͬ룬
+		const T* operator [](int row)const
 		{
-			if (row > this->row)
+			if (row < 0 || row >= this->row)
 			{
 				std::cout << "±곬" << std::endl;
-				return std::vector<T>(this->row, 0);
+				return spare_row();
 			}
 			else
 			{
-				return this->data[row];
+				return this->data + (std::size_t)row * this->col;
 			}
 		}
 
+		//
+		int get_row() const
+		{
+			return this->row;
+		}
+
+		//
+		int get_col() const
+		{
+			return this->col;
+		}
+
+		//ݵ׵ַ
+		T* get_data()
+		{
+			return this->data;
+		}
+		const T* get_data() const
+		{
+			return this->data;
+		}
+
+		//Ԫ
+		std::size_t size() const
+		{
+			return (std::size_t)this->row * this->col;
+		}
+
+		//ı״Ԫʱ·䣬ݲ
+		void resize(int size_row, int size_col)
+		{
+			if ((std::size_t)size_row * size_col != size())
+			{
+				deallocate();
+				this->row = size_row;
+				this->col = size_col;
+				allocate();
+			}
+			this->row = size_row;
+			this->col = size_col;
+		}
+
+		//+=ԭ
+		Matrix2x<T>& operator +=(const Matrix2x<T>& b)
+		{
+			if (this->row != b.row || this->col != b.col)
+			{
+				std::cout << "ӷʧЧǷһ" << std::endl;
+				return *this;
+			}
+			T* p = this->data;
+			const T* q = b.data;
+			std::size_t n = size();
+			for (std::size_t i = 0; i < n; i++)
+			{
+				p[i] += q[i];
+			}
+			return *this;
+		}
+
+		//-=ԭ
+		Matrix2x<T>& operator -=(const Matrix2x<T>& b)
+		{
+			if (this->row != b.row || this->col != b.col)
+			{
+				std::cout << "ʧЧǷһ" << std::endl;
+				return *this;
+			}
+			T* p = this->data;
+			const T* q = b.data;
+			std::size_t n = size();
+			for (std::size_t i = 0; i < n; i++)
+			{
+				p[i] -= q[i];
+			}
+			return *this;
+		}
+
+		//*=*=
+		Matrix2x<T>& operator *=(T a)
+		{
+			T* p = this->data;
+			std::size_t n = size();
+			for (std::size_t i = 0; i < n; i++)
+			{
+				p[i] *= a;
+			}
+			return *this;
+		}
+
+		//*=*=󣬽״ͨ˷ͬ
+		Matrix2x<T>& operator *=(const Matrix2x<T>& b)
+		{
+			if (b.row != this->col)
+			{
+				std::cout << "˷ʧЧǰǷͬ" << std::endl;
+				return *this;
+			}
+			Matrix2x<T>ends(this->row, b.col);
+			EIGEN1_STAT(stat_matrix_temp, "operator*=", ends.size() * sizeof(T));
+			gemm(T(1), *this, b, T(0), ends);
+			*this = std::move(ends);
+			return *this;
+		}
+
+		//ԭؾ˼ӣc = alpha * a * b + beta * c
+		//cѾ(a.row x b.col)Ҳabͬһ
+		friend void gemm(T alpha, const Matrix2x<T>& a, const Matrix2x<T>& b, T beta, Matrix2x<T>& c)
+		{
+			gemm(false, false, alpha, a, b, beta, c);
+		}
+
+		//תñ־ľ˼ӣc = alpha * op(a) * op(b) + beta * ctransΪtrueʱop(x)xתá
+		//תڴʱתõķʽɣתþ
+		friend void gemm(bool trans_a, bool trans_b, T alpha, const Matrix2x<T>& a, const Matrix2x<T>& b, T beta, Matrix2x<T>& c)
+		{
+			gemm(trans_a, trans_b, alpha, a, b, beta, c, detail::gemm_no_epilogue());
+		}
+
+		//ͬϣcÿһepilogue(i, j, p, len)Ԫصβ(pָc(i, j)lenԪ)
+		template<typename Epi>
+		friend void gemm(bool trans_a, bool trans_b, T alpha, const Matrix2x<T>& a, const Matrix2x<T>& b, T beta, Matrix2x<T>& c, Epi epilogue)
+		{
+			int m = trans_a ? a.col : a.row;
+			int k = trans_a ? a.row : a.col;
+			int kb = trans_b ? b.col : b.row;
+			int n = trans_b ? b.row : b.col;
+			if (kb != k || c.row != m || c.col != n)
+			{
+				std::cout << "˷ʧЧǰǷͬ" << std::endl;
+				return;
+			}
+			if (&c == &a || &c == &b)
+			{
+				std::cout << "gemmͬ" << std::endl;
+				return;
+			}
+			detail::gemm_kernel(trans_a, trans_b, m, n, k, alpha, a.data, a.col, b.data, b.col, beta, c.data, c.col, epilogue);
+		}
+
 		//+
 		friend Matrix2x<T> operator +(const Matrix2x<T>& a, const Matrix2x<T>& b)
 		{
-			if (a.row != b.row && a.col != b.col)
+			if (a.row != b.row || a.col != b.col)
 			{
 				std::cout << "ӷʧЧǷһ" << std::endl;
 				return a;
 			}
 			else
 			{
-				Matrix2x<T>ends(a.row, a.col);
-				for (int i = 0; i < a.row; i++)
-				{
-					for (int j = 0; j < a.col; j++)
-					{
-						ends[i][j] = a.data[i][j] + b.data[i][j];
-					}
-				}
+				Matrix2x<T>ends(a);
+				EIGEN1_STAT(stat_matrix_temp, "operator+", ends.size() * sizeof(T));
+				ends += b;
 				return ends;
 			}
 		}
 
+		//+ʱʱֱӸڴ
+		friend Matrix2x<T> operator +(Matrix2x<T>&& a, const Matrix2x<T>& b)
+		{
+			a += b;
+			return std::move(a);
+		}
+
 		//-
 		friend Matrix2x<T> operator -(const Matrix2x<T>& a, const Matrix2x<T>& b)
 		{
-			if (a.row != b.row && a.col != b.col)
+			if (a.row != b.row || a.col != b.col)
 			{
 				std::cout << "ʧЧǷһ" << std::endl;
 				return a;
 			}
 			else
 			{
-				Matrix2x<T>ends(a.row, a.col);
-				for (int i = 0; i < a.row; i++)
-				{
-					for (int j = 0; j < a.col; j++)
-					{
-						ends[i][j] = a.data[i][j] - b.data[i][j];
-					}
-				}
+				Matrix2x<T>ends(a);
+				EIGEN1_STAT(stat_matrix_temp, "operator-", ends.size() * sizeof(T));
+				ends -= b;
 				return ends;
 			}
 		}
 
+		//-ʱʱֱӸڴ
+		friend Matrix2x<T> operator -(Matrix2x<T>&& a, const Matrix2x<T>& b)
+		{
+			a -= b;
+			return std::move(a);
+		}
+
 		//**
 		friend Matrix2x<T> operator * (const Matrix2x<T>& a, const Matrix2x<T>& b)
 		{
@@ -159,22 +613,8 @@ namespace Eigen1
 			else
 			{
 				Matrix2x ends(a.row, b.col);
-				int ends_row = a.row;
-				int ends_col = b.col;
-				for (int i = 0; i < ends_row; i++)
-				{
-					for (int j = 0; j < ends_col; j++)
-					{
-						T temp = 0;
-						for (int k = 0; k < a.col; k++)
-						{
-							T tempa = a[i][k];
-							T tempb = b[k][j];
-							temp += a[i][k] * b[k][j];
-						}
-						ends[i][j] = temp;
-					}
-				}
+				EIGEN1_STAT(stat_matrix_temp, "operator*", ends.size() * sizeof(T));
+				gemm(T(1), a, b, T(0), ends);
 				return ends;
 			}
 		}
@@ -183,16 +623,9 @@ namespace Eigen1
 		template<typename U>
 		friend Matrix2x<T> operator *(U a, const Matrix2x<T>& b)
 		{
-			a = T(a);
 			Matrix2x<T>ends(b);
-			for (int i = 0; i < ends.row; i++)
-			{
-				for (int j = 0; j < ends.col; j++)
-				{
-					auto temp = ends[i][j] * a;
-					ends[i][j] = temp;
-				}
-			}
+			EIGEN1_STAT(stat_matrix_temp, "scalar operator*", ends.size() * sizeof(T));
+			ends *= T(a);
 			return ends;
 		}
 
@@ -203,8 +636,9 @@ namespace Eigen1
 			return a * b;
 		}
 
-		//
-		Matrix2x<T> inv()
+		//棬ԪGauss-JordanԪ
+		//[A|I]̵߳WorkspaceͬСľ󷴸ʱٷڴ
+		Matrix2x<T> inv() const
 		{
 			if (this->row != this->col)
 			{
@@ -213,106 +647,78 @@ namespace Eigen1
 			}
 			else
 			{
-				int count = 0;
-				for (int i = 0; i < row; i++)
-				{
-					if (abs(this->data[i][0]) < zero_rate)
-					{
-						count++;
-					}
-				}
-				if (count == this->row)
+				int n = this->row;
+				int w = n * 2;
+				T* temp1 = Workspace::local().get<T>(Workspace::ws_inv, (std::size_t)n * w);
+				for (int i = 0; i < n; i++)
 				{
-					std::cout << "ȿ޷ʵ־" << std::endl;
-					return *this;
+					T* p = temp1 + (std::size_t)i * w;
+					std::copy_n(this->data + (std::size_t)i * n, n, p);
+					std::fill_n(p + n, n, T(0));
+					p[n + i] = 1;
 				}
-				else
+
+				for (int i = 0; i < n; i++)
 				{
-					Matrix2x temp1(this->row, this->col * 2);
-					for (int i = 0; i < this->row; i++)
+					//ѡiоֵԪ
+					int pivot = i;
+					for (int j = i + 1; j < n; j++)
 					{
-						for (int j = 0; j < this->col; j++)
+						if (std::abs(temp1[(std::size_t)j * w + i]) > std::abs(temp1[(std::size_t)pivot * w + i]))
 						{
-							temp1[i][j] = this->data[i][j];
+							pivot = j;
 						}
 					}
-					for (int i = 0; i < this->row; i++)
+					if (std::abs(temp1[(std::size_t)pivot * w + i]) < zero_rate)
 					{
-						temp1[i][i + this->col] = 1;
+						std::cout << "ȿ޷ʵ־" << std::endl;
+						return *this;
 					}
-
-					for (int i = 0; i < this->col; i++)
+					T* pi = temp1 + (std::size_t)i * w;
+					if (pivot != i)
 					{
-						for (int j = i; j < this->row; j++)
-						{
-							if (abs(temp1[j][i]) < zero_rate)
-							{
-								for (int k = j; k < this->row; k++)
-								{
-									if (abs(temp1[k][i]) > zero_rate)
-										swap(temp1.data[j], temp1.data[k]);
-								}
-							}
-						}
-
-						T temp2 = temp1[i][i];
-						for (int j = 0; j < this->col * 2; j++)
-						{
-							temp1[i][j] = temp1[i][j] / temp2;
-						}
-						std::vector<T>temp4 = temp1.data[i];
-						for (int j = 0; j < this->row; j++)
-						{
-							if (j == i)
-								continue;
-							else
-							{
-								T temp3 = temp1[j][i];
-								for (int k = 0; k < this->col * 2; k++)
-								{
-									temp1[j][k] = temp1[j][k] - temp3 * temp4[k];
-								}
-							}
-						}
-
-
-						for (int j = i + 1; j < this->col; j++)
-						{
-							int count = 0;
-							for (int k = 0; k < this->row; k++)
-							{
-								if (abs(temp1[k][j]) < zero_rate)
-									count++;
-							}
-							if (count == this->row)
-							{
-								std::cout << "ȿ޷ʵ־" << std::endl;
-								return *this;
-							}
-						}
+						std::swap_ranges(pi, pi + w, temp1 + (std::size_t)pivot * w);
 					}
 
-					Matrix2x<T>ends(this->row, this->col);
-					for (int i = 0; i < this->row; i++)
+					T temp2 = T(1) / pi[i];
+					for (int j = i; j < w; j++)
 					{
-						for (int j = 0; j < this->col; j++)
+						pi[j] *= temp2;
+					}
+					//ԪڱֲᱻĶֱԪٿһ
+					for (int j = 0; j < n; j++)
+					{
+						if (j == i)
+							continue;
+						T* pj = temp1 + (std::size_t)j * w;
+						T temp3 = pj[i];
+						if (temp3 == T(0))
+							continue;
+						for (int k = i; k < w; k++)
 						{
-							ends[i][j] = temp1[i][j + this->col];
+							pj[k] -= temp3 * pi[k];
 						}
 					}
-					return ends;
 				}
+
+				Matrix2x<T>ends(n, n);
+				EIGEN1_STAT(stat_matrix_temp, "inv", ends.size() * sizeof(T));
+				for (int i = 0; i < n; i++)
+				{
+					std::copy_n(temp1 + (std::size_t)i * w + n, n, ends.data + (std::size_t)i * n);
+				}
+				return ends;
 			}
 		}
 
 		//չʾ
-		void show()
+		void show() const
 		{
-			for (int i = 0; i < this->col; i++)
+			for (int i = 0; i < this->row; i++)
 			{
 				for (int j = 0; j < this->col; j++)
 				{
-					std::cout << this->data[i][j] << " ";
+					std::cout << this->data[(std::size_t)i * this->col + j] << " ";
 				}
 				std::cout << std::endl;
 			}
@@ -0,0 +1,262 @@
+#pragma once
+#ifndef _EIGEN1_BATCH_H_
+#define _EIGEN1_BATCH_H_
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "eigen1_fixed.h"
+#include "eigen1_memory.h"
+#include "eigen1_parallel.h"
+
+//ͬߴС󣬰"ṹ"(SoA)洢
+//b(i, j)Ԫط data[(i * C + j) * count + b]
+//ͬһλõԪڴģڲѭžbߣ
+//ÿSIMDͨһͬľ󣬱ֱڷ֧ɢ
+
+namespace Eigen1
+{
+	namespace detail
+	{
+		//ʱһδľȡһAVX-512Ĵܷµdouble
+		const int batch_width = 16;
+
+		//ջСĵwͨһд洢ľ
+		template<typename T, int W>
+		struct lane_ref
+		{
+			T(*p)[W];
+			int w;
+
+			T& operator [](int k) const
+			{
+				return p[k][w];
+			}
+		};
+	}
+
+	template<typename T, int R, int C>
+	class MatrixBatch
+	{
+		static_assert(R > 0 && C > 0, "MatrixBatchб0");
+
+	private:
+		int count;//
+		aligned_vector<T> data;
+
+		//ÿ߳ٷֵôſ߳
+		static const int parallel_count = 4096;
+
+		template<typename F>
+		static void for_each_block(int n, F f)
+		{
+			parallel_for(0, n, parallel_count, [&](long long lo, long long hi) { f((int)lo, (int)hi); });
+		}
+
+	public:
+		//Ĭϳʼ
+		MatrixBatch() :count(0) {};
+
+		//n
+		explicit MatrixBatch(int n) :count(n), data((std::size_t)n * R * C, T(0)) {};
+
+		//
+		int size() const
+		{
+			return count;
+		}
+
+		//
+		static constexpr int get_row()
+		{
+			return R;
+		}
+
+		//
+		static constexpr int get_col()
+		{
+			return C;
+		}
+
+		//(i, j)Ԫоһ飬Ϊsize()
+		T* lane(int i, int j)
+		{
+			return data.data() + (std::size_t)(i * C + j) * count;
+		}
+		const T* lane(int i, int j) const
+		{
+			return data.data() + (std::size_t)(i * C + j) * count;
+		}
+
+		//дb(i, j)Ԫ
+		T& at(int b, int i, int j)
+		{
+			return lane(i, j)[b];
+		}
+		T at(int b, int i, int j) const
+		{
+			return lane(i, j)[b];
+		}
+
+		//ȡb
+		Matrix<T, R, C> get(int b) const
+		{
+			Matrix<T, R, C>ends;
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+				{
+					ends[i][j] = at(b, i, j);
+				}
+			}
+			return ends;
+		}
+
+		//дb
+		void set(int b, const Matrix<T, R, C>& m)
+		{
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+				{
+					at(b, i, j) = m[i][j];
+				}
+			}
+		}
+
+		//棬ľ(жMatrixinv()ͬھ)㲢okΪfalse(okΪ)
+		friend void batch_inv(const MatrixBatch<T, R, C>& a, MatrixBatch<T, R, C>& out, bool* ok)
+		{
+			static_assert(R == C, "Ϊ޷ʵ־");
+			if (out.count != a.count)
+			{
+				out = MatrixBatch<T, R, C>(a.count);
+			}
+			int n = a.count;
+			for_each_block(n, [&](int lo, int hi) {
+				//ÿΰWջϵСڰͨw޷֧ıʽ棬ѭֱ
+				const int W = detail::batch_width;
+				T in[R * C][W];
+				T res[R * C][W];
+				T det[W];
+				bool good[W];
+				for (int b0 = lo; b0 < hi; b0 += W)
+				{
+					int w_count = std::min(W, hi - b0);
+					for (int k = 0; k < R * C; k++)
+					{
+						const T* src = a.data.data() + (std::size_t)k * n + b0;
+						for (int w = 0; w < W; w++)
+						{
+							in[k][w] = w < w_count ? src[w] : T(0);
+						}
+					}
+					for (int w = 0; w < W; w++)
+					{
+						detail::lane_ref<const T, W> m = { in, w };
+						det[w] = detail::fixed_inv<T, R>::det(m);
+						good[w] = !detail::fixed_singular<T, R>(m, det[w]);
+					}
+					for (int w = 0; w < W; w++)
+					{
+						detail::lane_ref<const T, W> m = { in, w };
+						detail::lane_ref<T, W> o = { res, w };
+						detail::fixed_inv<T, R>::adj(m, good[w] ? T(1) / det[w] : T(0), o);
+					}
+					for (int k = 0; k < R * C; k++)
+					{
+						T* dst = out.data.data() + (std::size_t)k * n + b0;
+						for (int w = 0; w < w_count; w++)
+						{
+							dst[w] = res[k][w];
+						}
+					}
+					if (ok != nullptr)
+					{
+						for (int w = 0; w < w_count; w++)
+						{
+							ok[b0 + w] = good[w];
+						}
+					}
+				}
+			});
+		}
+	};
+
+	//˷out[b] = a[b] * x[b]ÿ(i, j)һbĳ˼ˮ
+	//outܺaxͬһ(дḲǻҪõԪ)ֱӾܾ
+	template<typename T, int R, int K, int C>
+	void batch_multiply(const MatrixBatch<T, R, K>& a, const MatrixBatch<T, K, C>& x, MatrixBatch<T, R, C>& out)
+	{
+		if (a.size() != x.size())
+		{
+			std::cout << "˷ʧЧĸǷͬ" << std::endl;
+			return;
+		}
+		if ((const void*)&out == (const void*)&a || (const void*)&out == (const void*)&x)
+		{
+			std::cout << "˷ʧЧͬһ" << std::endl;
+			return;
+		}
+		int n = a.size();
+		if (out.size() != n)
+		{
+			out = MatrixBatch<T, R, C>(n);
+		}
+		parallel_for(0, n, 4096, [&](long long lo, long long hi) {
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+				{
+					T* po = out.lane(i, j);
+					const T* pa0 = a.lane(i, 0);
+					const T* px0 = x.lane(0, j);
+					for (long long b = lo; b < hi; b++)
+					{
+						po[b] = pa0[b] * px0[b];
+					}
+					for (int k = 1; k < K; k++)
+					{
+						const T* pa = a.lane(i, k);
+						const T* px = x.lane(k, j);
+						for (long long b = lo; b < hi; b++)
+						{
+							po[b] += pa[b] * px[b];
+						}
+					}
+				}
+			}
+		});
+	}
+
+	//Է飺x[b] = a[b]^-1 * y[b]yж
+	//棬Ҷ24׵СԪʺ
+	//ڵ߸scratchСʱòٷ
+	template<typename T, int R, int K>
+	void batch_solve(const MatrixBatch<T, R, R>& a, const MatrixBatch<T, R, K>& y, MatrixBatch<T, R, K>& x, bool* ok, MatrixBatch<T, R, R>& scratch)
+	{
+		if (a.size() != y.size())
+		{
+			std::cout << "ʧЧϵҶĸǷͬ" << std::endl;
+			return;
+		}
+		if (&scratch == &a)
+		{
+			std::cout << "ʧЧscratchϵ" << std::endl;
+			return;
+		}
+		batch_inv(a, scratch, ok);
+		batch_multiply(scratch, y, x);
+	}
+
+	//ͬϣÿ̸߳ԵĻͬߴⲻٷ
+	template<typename T, int R, int K>
+	void batch_solve(const MatrixBatch<T, R, R>& a, const MatrixBatch<T, R, K>& y, MatrixBatch<T, R, K>& x, bool* ok)
+	{
+		static thread_local MatrixBatch<T, R, R> scratch;
+		batch_solve(a, y, x, ok, scratch);
+	}
+}
+
+#endif // !_EIGEN1_BATCH_H_
@@ -0,0 +1,419 @@
+#pragma once
+#ifndef _EIGEN1_FIXED_H_
+#define _EIGEN1_FIXED_H_
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "eigen1.h"
+
+//ڶֱӴڶڲ(ջ)ѷ䡣
+//ӿھMatrix2xһ£[]ȡС+ - *+= -= *=inv()show()
+//ѭȫunrollģչ2x24x4ʽñʽʽ
+
+namespace Eigen1
+{
+	namespace detail
+	{
+		//չѭεf(0), f(1), ..., f(N-1)
+		template<int N>
+		struct unroll
+		{
+			template<typename F>
+			static inline void run(F&& f)
+			{
+				unroll<N - 1>::run(f);
+				f(N - 1);
+			}
+		};
+
+		template<>
+		struct unroll<0>
+		{
+			template<typename F>
+			static inline void run(F&&) {}
+		};
+
+		//ʽʽֻ234׷ػ
+		template<typename T, int N>
+		struct fixed_inv;
+	}
+
+	template<typename T, int R, int C>
+	class Matrix
+	{
+		static_assert(R > 0 && C > 0, "Matrixб0");
+
+	private:
+		T data[R * C];//д洢
+
+	public:
+		//ĬϳʼΪ
+		Matrix()
+		{
+			detail::unroll<R * C>::run([&](int i) { data[i] = T(0); });
+		}
+
+		//쵥λ󣬺Matrix2x(n,'I')Ӧ
+		explicit Matrix(char c)
+		{
+			detail::unroll<R * C>::run([&](int i) { data[i] = T(0); });
+			if (c == 'I')
+			{
+				detail::unroll<(R < C ? R : C)>::run([&](int i) { data[i * C + i] = T(1); });
+			}
+			else
+			{
+				std::cout << "ͲĬϷ" << std::endl;
+			}
+		}
+
+		//Ӷ̬󿽱״һʱ
+		explicit Matrix(const Matrix2x<T>& a)
+		{
+			detail::unroll<R * C>::run([&](int i) { data[i] = T(0); });
+			if (a.get_row() != R || a.get_col() != C)
+			{
+				std::cout << "״һ£ĬϷ" << std::endl;
+				return;
+			}
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+				{
+					data[i * C + j] = a[i][j];
+				}
+			}
+		}
+
+		//תɶ̬
+		Matrix2x<T> to_matrix2x() const
+		{
+			Matrix2x<T>ends(R, C);
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+				{
+					ends[i][j] = data[i * C + j];
+				}
+			}
+			return ends;
+		}
+
+		//[]ָ룬Խ
+		T* operator [](int row)
+		{
+			return data + row * C;
+		}
+		const T* operator [](int row) const
+		{
+			return data + row * C;
+		}
+
+		//
+		static constexpr int get_row()
+		{
+			return R;
+		}
+
+		//
+		static constexpr int get_col()
+		{
+			return C;
+		}
+
+		//+=
+		Matrix& operator +=(const Matrix& b)
+		{
+			detail::unroll<R * C>::run([&](int i) { data[i] += b.data[i]; });
+			return *this;
+		}
+
+		//-=
+		Matrix& operator -=(const Matrix& b)
+		{
+			detail::unroll<R * C>::run([&](int i) { data[i] -= b.data[i]; });
+			return *this;
+		}
+
+		//*=*=
+		Matrix& operator *=(T a)
+		{
+			detail::unroll<R * C>::run([&](int i) { data[i] *= a; });
+			return *this;
+		}
+
+		//+
+		friend Matrix operator +(Matrix a, const Matrix& b)
+		{
+			a += b;
+			return a;
+		}
+
+		//-
+		friend Matrix operator -(Matrix a, const Matrix& b)
+		{
+			a -= b;
+			return a;
+		}
+
+		//**
+		friend Matrix operator *(T a, Matrix b)
+		{
+			b *= a;
+			return b;
+		}
+
+		//**
+		friend Matrix operator *(Matrix b, T a)
+		{
+			b *= a;
+			return b;
+		}
+
+		//ת
+		Matrix<T, C, R> transpose() const
+		{
+			Matrix<T, C, R>ends;
+			detail::unroll<R>::run([&](int i) {
+				detail::unroll<C>::run([&](int j) { ends[j][i] = data[i * C + j]; });
+			});
+			return ends;
+		}
+
+		//ʽֻ֧24׷
+		T det() const
+		{
+			static_assert(R == C, "Ϊ޷ʽ");
+			return detail::fixed_inv<T, R>::det(data);
+		}
+
+		//棬ֻ֧24׷ʱMatrix2xһӡʾ
+		Matrix inv() const
+		{
+			static_assert(R == C, "Ϊ޷ʵ־");
+			Matrix ends;
+			if (!detail::fixed_inv<T, R>::inv(data, ends.data))
+			{
+				std::cout << "ȿ޷ʵ־" << std::endl;
+				return *this;
+			}
+			return ends;
+		}
+
+		//չʾ
+		void show() const
+		{
+			for (int i = 0; i < R; i++)
+			{
+				for (int j = 0; j < C; j++)
+				{
+					std::cout << data[i * C + j] << " ";
+				}
+				std::cout << std::endl;
+			}
+		}
+	};
+
+	//**ѭȫչ
+	template<typename T, int R, int K, int C>
+	inline Matrix<T, R, C> operator *(const Matrix<T, R, K>& a, const Matrix<T, K, C>& b)
+	{
+		Matrix<T, R, C>ends;
+		detail::unroll<R>::run([&](int i) {
+			detail::unroll<C>::run([&](int j) {
+				T temp = a[i][0] * b[0][j];
+				detail::unroll<K - 1>::run([&](int k) { temp += a[i][k + 1] * b[k + 1][j]; });
+				ends[i][j] = temp;
+			});
+		});
+		return ends;
+	}
+
+	//óߴ
+	template<typename T> using Matrix2 = Matrix<T, 2, 2>;
+	template<typename T> using Matrix3 = Matrix<T, 3, 3>;
+	template<typename T> using Matrix4 = Matrix<T, 4, 4>;
+
+	namespace detail
+	{
+		//жֵֵMatrix2xzero_rateͬ
+		const double fixed_zero_rate = 0.000001;
+
+		//|det| <= fixed_zero_rate * ||m||^R ʱΪ죬||m||ȡ(оֵ͵ֵ)
+		//ֵĴСţ0.03*IܺáֵֻСľ󲻻ᱻУ
+		//ûз֧ﰴͨҲд!(>)ΪNaNҲ
+		template<typename T, int R, typename M>
+		bool fixed_singular(const M& m, T d)
+		{
+			T norm = T(0);
+			for (int i = 0; i < R; i++)
+			{
+				T s = T(0);
+				for (int j = 0; j < R; j++)
+				{
+					s += std::abs(m[i * R + j]);
+				}
+				norm = std::max(norm, s);
+			}
+			T scale = T(fixed_zero_rate);
+			for (int k = 0; k < R; k++)
+			{
+				scale *= norm;
+			}
+			return !(std::abs(d) > scale);
+		}
+
+		//moutֻҪ֧m[k]ȡkԪأȿָ룬Ҳﰴͨȡֵķ
+		//det()ʽadj()дr߶ûз֧inv()ڴ˻ж졣
+		template<typename T>
+		struct fixed_inv<T, 2>
+		{
+			template<typename M>
+			static T det(const M& m)
+			{
+				return m[0] * m[3] - m[1] * m[2];
+			}
+
+			template<typename M, typename O>
+			static void adj(const M& m, T r, O& out)
+			{
+				T m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3];
+				out[0] = m3 * r;
+				out[1] = -m1 * r;
+				out[2] = -m2 * r;
+				out[3] = m0 * r;
+			}
+
+			static bool inv(const T* m, T* out)
+			{
+				T d = det(m);
+				if (fixed_singular<T, 2>(m, d))
+				{
+					return false;
+				}
+				adj(m, T(1) / d, out);
+				return true;
+			}
+		};
+
+		template<typename T>
+		struct fixed_inv<T, 3>
+		{
+			template<typename M>
+			static T det(const M& m)
+			{
+				return m[0] * (m[4] * m[8] - m[5] * m[7])
+					- m[1] * (m[3] * m[8] - m[5] * m[6])
+					+ m[2] * (m[3] * m[7] - m[4] * m[6]);
+			}
+
+			//ʽ
+			template<typename M, typename O>
+			static void adj(const M& m, T r, O& out)
+			{
+				T a[9];
+				for (int k = 0; k < 9; k++)
+				{
+					a[k] = m[k];
+				}
+				out[0] = (a[4] * a[8] - a[5] * a[7]) * r;
+				out[1] = (a[2] * a[7] - a[1] * a[8]) * r;
+				out[2] = (a[1] * a[5] - a[2] * a[4]) * r;
+				out[3] = (a[5] * a[6] - a[3] * a[8]) * r;
+				out[4] = (a[0] * a[8] - a[2] * a[6]) * r;
+				out[5] = (a[2] * a[3] - a[0] * a[5]) * r;
+				out[6] = (a[3] * a[7] - a[4] * a[6]) * r;
+				out[7] = (a[1] * a[6] - a[0] * a[7]) * r;
+				out[8] = (a[0] * a[4] - a[1] * a[3]) * r;
+			}
+
+			static bool inv(const T* m, T* out)
+			{
+				T d = det(m);
+				if (fixed_singular<T, 3>(m, d))
+				{
+					return false;
+				}
+				adj(m, T(1) / d, out);
+				return true;
+			}
+		};
+
+		template<typename T>
+		struct fixed_inv<T, 4>
+		{
+			//ке2x2ʽչ(Laplaceչ)12ʽ
+			template<typename M>
+			static void minors(const M& m, T* s, T* c)
+			{
+				s[0] = m[0] * m[5] - m[4] * m[1];
+				s[1] = m[0] * m[6] - m[4] * m[2];
+				s[2] = m[0] * m[7] - m[4] * m[3];
+				s[3] = m[1] * m[6] - m[5] * m[2];
+				s[4] = m[1] * m[7] - m[5] * m[3];
+				s[5] = m[2] * m[7] - m[6] * m[3];
+
+				c[5] = m[10] * m[15] - m[14] * m[11];
+				c[4] = m[9] * m[15] - m[13] * m[11];
+				c[3] = m[9] * m[14] - m[13] * m[10];
+				c[2] = m[8] * m[15] - m[12] * m[11];
+				c[1] = m[8] * m[14] - m[12] * m[10];
+				c[0] = m[8] * m[13] - m[12] * m[9];
+			}
+
+			template<typename M>
+			static T det(const M& m)
+			{
+				T s[6], c[6];
+				minors(m, s, c);
+				return s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+			}
+
+			template<typename M, typename O>
+			static void adj(const M& m, T r, O& out)
+			{
+				T a[16];
+				for (int k = 0; k < 16; k++)
+				{
+					a[k] = m[k];
+				}
+				T s[6], c[6];
+				minors(a, s, c);
+				out[0] = (a[5] * c[5] - a[6] * c[4] + a[7] * c[3]) * r;
+				out[1] = (-a[1] * c[5] + a[2] * c[4] - a[3] * c[3]) * r;
+				out[2] = (a[13] * s[5] - a[14] * s[4] + a[15] * s[3]) * r;
+				out[3] = (-a[9] * s[5] + a[10] * s[4] - a[11] * s[3]) * r;
+
+				out[4] = (-a[4] * c[5] + a[6] * c[2] - a[7] * c[1]) * r;
+				out[5] = (a[0] * c[5] - a[2] * c[2] + a[3] * c[1]) * r;
+				out[6] = (-a[12] * s[5] + a[14] * s[2] - a[15] * s[1]) * r;
+				out[7] = (a[8] * s[5] - a[10] * s[2] + a[11] * s[1]) * r;
+
+				out[8] = (a[4] * c[4] - a[5] * c[2] + a[7] * c[0]) * r;
+				out[9] = (-a[0] * c[4] + a[1] * c[2] - a[3] * c[0]) * r;
+				out[10] = (a[12] * s[4] - a[13] * s[2] + a[15] * s[0]) * r;
+				out[11] = (-a[8] * s[4] + a[9] * s[2] - a[11] * s[0]) * r;
+
+				out[12] = (-a[4] * c[3] + a[5] * c[1] - a[6] * c[0]) * r;
+				out[13] = (a[0] * c[3] - a[1] * c[1] + a[2] * c[0]) * r;
+				out[14] = (-a[12] * s[3] + a[13] * s[1] - a[14] * s[0]) * r;
+				out[15] = (a[8] * s[3] - a[9] * s[1] + a[10] * s[0]) * r;
+			}
+
+			static bool inv(const T* m, T* out)
+			{
+				T d = det(m);
+				if (fixed_singular<T, 4>(m, d))
+				{
+					return false;
+				}
+				adj(m, T(1) / d, out);
+				return true;
+			}
+		};
+	}
+}
+
+#endif // !_EIGEN1_FIXED_H_
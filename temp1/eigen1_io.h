@@ -0,0 +1,910 @@
+#pragma once
+#ifndef _EIGEN1_IO_H_
+#define _EIGEN1_IO_H_
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+#include "eigen1.h"
+#include "eigen1_memory.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Ķд
+//1.Ƹʽ64ֽļͷ(ħ汾͡/вƫ)д洢ԭʼݡ
+//  ݴӵ64ֽڿʼmmap֮Ȼ64ֽڶ룬MappedMatrix㿽ֱӵֻá
+//2.CSV/TSVCsvReaderļԼֱ֣дľڴ棬Ϊÿһзڴ棻
+//  ļһһض̶СľﴦҪļŽڴ档
+
+namespace Eigen1
+{
+	//ļͱ
+	enum matrix_dtype
+	{
+		dtype_unknown = 0,
+		dtype_float32 = 1,
+		dtype_float64 = 2,
+		dtype_int32 = 3,
+		dtype_int8 = 4
+	};
+
+	template<typename T> struct dtype_of { static const int value = dtype_unknown; };
+	template<> struct dtype_of<float> { static const int value = dtype_float32; };
+	template<> struct dtype_of<double> { static const int value = dtype_float64; };
+	template<> struct dtype_of<std::int32_t> { static const int value = dtype_int32; };
+	template<> struct dtype_of<std::int8_t> { static const int value = dtype_int8; };
+
+	//ļͷ̶64ֽڣС
+	struct MatrixFileHeader
+	{
+		char magic[8];//"EIG1MAT"
+		std::uint32_t version;
+		std::uint32_t dtype;
+		std::int64_t rows;
+		std::int64_t cols;
+		std::int64_t row_stride;//иٸԪ
+		std::int64_t col_stride;//иٸԪ
+		std::uint64_t data_offset;//ݴļڼֽڿʼ
+		std::uint64_t reserved;//д0
+	};
+	static_assert(sizeof(MatrixFileHeader) == 64, "MatrixFileHeader64ֽ");
+
+	namespace detail
+	{
+		const char matrix_magic[8] = { 'E', 'I', 'G', '1', 'M', 'A', 'T', '\0' };
+		const std::uint32_t matrix_version = 1;
+
+		inline std::FILE* open_file(const std::string& path, const char* mode)
+		{
+			std::FILE* f = nullptr;
+#ifdef _MSC_VER
+			if (fopen_s(&f, path.c_str(), mode) != 0)
+			{
+				f = nullptr;
+			}
+#else
+			f = std::fopen(path.c_str(), mode);
+#endif
+			return f;
+		}
+
+		//ļܳ(ֽ)λƻؿͷʧܷfalse
+		inline bool file_length(std::FILE* f, std::uint64_t& length)
+		{
+#ifdef _MSC_VER
+			if (_fseeki64(f, 0, SEEK_END) != 0)
+			{
+				return false;
+			}
+			long long n = _ftelli64(f);
+			bool good = n >= 0 && _fseeki64(f, 0, SEEK_SET) == 0;
+#else
+			if (fseeko(f, 0, SEEK_END) != 0)
+			{
+				return false;
+			}
+			off_t n = ftello(f);
+			bool good = n >= 0 && fseeko(f, 0, SEEK_SET) == 0;
+#endif
+			length = good ? (std::uint64_t)n : 0;
+			return good;
+		}
+
+		//ļͷļȡͷļţ
+		//ܷŽintݷΧ(rows-1)*row_stride+(cols-1)*col_stride+1ļóжϲ
+		//ļҪrows*colsԪأʱڴ治ᳬļĴС
+		template<typename T>
+		bool check_header(const MatrixFileHeader& h, std::uint64_t file_size)
+		{
+			if (std::memcmp(h.magic, matrix_magic, 8) != 0 || h.version != matrix_version)
+			{
+				std::cout << "Ǿļ汾֧" << std::endl;
+				return false;
+			}
+			if ((int)h.dtype != dtype_of<T>::value)
+			{
+				std::cout << "ļȡͲһ" << std::endl;
+				return false;
+			}
+			if (h.rows < 0 || h.cols < 0 || h.rows > INT_MAX || h.cols > INT_MAX || h.row_stride < 0 || h.col_stride < 0
+				|| h.data_offset < sizeof(MatrixFileHeader))
+			{
+				std::cout << "ļͷ" << std::endl;
+				return false;
+			}
+			if (h.rows == 0 || h.cols == 0)
+			{
+				return true;
+			}
+			if (h.data_offset > file_size)
+			{
+				std::cout << "ļȲ㣬ݲ" << std::endl;
+				return false;
+			}
+			//availܷżԪ
+			std::uint64_t avail = (file_size - h.data_offset) / sizeof(T);
+			std::uint64_t r = (std::uint64_t)h.rows - 1;
+			std::uint64_t c = (std::uint64_t)h.cols - 1;
+			std::uint64_t rs = (std::uint64_t)h.row_stride;
+			std::uint64_t cs = (std::uint64_t)h.col_stride;
+			bool good = (rs == 0 || r <= avail / rs) && (cs == 0 || c <= avail / cs);
+			good = good && r * rs < avail && c * cs < avail - r * rs;
+			good = good && (std::uint64_t)h.cols <= avail / (std::uint64_t)h.rows;
+			if (!good)
+			{
+				std::cout << "ļȲ㣬ݲ" << std::endl;
+				return false;
+			}
+			return true;
+		}
+	}
+
+	//Ѿ󰴶Ƹʽдļɹtrue
+	template<typename T>
+	bool save_binary(const Matrix2x<T>& a, const std::string& path)
+	{
+		static_assert(dtype_of<T>::value != dtype_unknown, "ָ֧͵Ķƴ洢");
+		std::FILE* f = detail::open_file(path, "wb");
+		if (f == nullptr)
+		{
+			std::cout << "޷ļ" << path << std::endl;
+			return false;
+		}
+		MatrixFileHeader h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, detail::matrix_magic, 8);
+		h.version = detail::matrix_version;
+		h.dtype = dtype_of<T>::value;
+		h.rows = a.get_row();
+		h.cols = a.get_col();
+		h.row_stride = a.get_col();
+		h.col_stride = 1;
+		h.data_offset = sizeof(MatrixFileHeader);
+		bool good = std::fwrite(&h, sizeof(h), 1, f) == 1;
+		if (good && a.size() > 0)
+		{
+			good = std::fwrite(a.get_data(), sizeof(T), a.size(), f) == a.size();
+		}
+		good = std::fclose(f) == 0 && good;
+		if (!good)
+		{
+			std::cout << "дļʧܣ" << path << std::endl;
+		}
+		return good;
+	}
+
+	//Ӷļ(ڴ)ʧܷؿվ
+	template<typename T>
+	Matrix2x<T> load_binary(const std::string& path)
+	{
+		std::FILE* f = detail::open_file(path, "rb");
+		if (f == nullptr)
+		{
+			std::cout << "޷ļ" << path << std::endl;
+			return Matrix2x<T>();
+		}
+		MatrixFileHeader h;
+		std::uint64_t length = 0;
+		if (!detail::file_length(f, length) || std::fread(&h, sizeof(h), 1, f) != 1 || !detail::check_header<T>(h, length))
+		{
+			std::fclose(f);
+			return Matrix2x<T>();
+		}
+		Matrix2x<T>ends((int)h.rows, (int)h.cols);
+		bool good = true;
+		if (ends.size() > 0)
+		{
+#ifdef _MSC_VER
+			good = _fseeki64(f, (long long)h.data_offset, SEEK_SET) == 0;
+#else
+			good = fseeko(f, (off_t)h.data_offset, SEEK_SET) == 0;
+#endif
+			if (good && h.col_stride == 1 && h.row_stride == h.cols)
+			{
+				//洢һζ
+				good = std::fread(ends.get_data(), sizeof(T), ends.size(), f) == ends.size();
+			}
+			else if (good)
+			{
+				//Ĵ洢жٰȡֵ
+				std::vector<T> line((std::size_t)((h.cols - 1) * h.col_stride + 1));
+				for (int i = 0; good && i < ends.get_row(); i++)
+				{
+#ifdef _MSC_VER
+					good = _fseeki64(f, (long long)(h.data_offset + (std::uint64_t)i * h.row_stride * sizeof(T)), SEEK_SET) == 0;
+#else
+					good = fseeko(f, (off_t)(h.data_offset + (std::uint64_t)i * h.row_stride * sizeof(T)), SEEK_SET) == 0;
+#endif
+					good = good && std::fread(line.data(), sizeof(T), line.size(), f) == line.size();
+					for (int j = 0; good && j < ends.get_col(); j++)
+					{
+						ends[i][j] = line[(std::size_t)j * h.col_stride];
+					}
+				}
+			}
+		}
+		std::fclose(f);
+		if (!good)
+		{
+			std::cout << "ļȲ㣬ݲ" << std::endl;
+			return Matrix2x<T>();
+		}
+		return ends;
+	}
+
+	//ֻӳļݣҳɲϵͳ
+	class MappedFile
+	{
+	private:
+		void* base = nullptr;//ӳʼַ
+		std::size_t length = 0;//ӳĳ
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#endif
+
+		void take(MappedFile& a)
+		{
+			base = a.base;
+			length = a.length;
+#ifdef _WIN32
+			file = a.file;
+			mapping = a.mapping;
+			a.file = INVALID_HANDLE_VALUE;
+			a.mapping = nullptr;
+#endif
+			a.base = nullptr;
+			a.length = 0;
+		}
+
+	public:
+		MappedFile() {};
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator =(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& a) noexcept
+		{
+			take(a);
+		}
+
+		MappedFile& operator =(MappedFile&& a) noexcept
+		{
+			if (this != &a)
+			{
+				close();
+				take(a);
+			}
+			return *this;
+		}
+
+		~MappedFile()
+		{
+			close();
+		}
+
+		//ӳļļmin_sizeֽʱʧܣɹtrue
+		bool open(const std::string& path, std::size_t min_size)
+		{
+			close();
+#ifdef _WIN32
+			file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				std::cout << "޷ļ" << path << std::endl;
+				return false;
+			}
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)min_size || size.QuadPart == 0)
+			{
+				std::cout << "ļȲ㣬ݲ" << path << std::endl;
+				close();
+				return false;
+			}
+			length = (std::size_t)size.QuadPart;
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			base = mapping == nullptr ? nullptr : MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (base == nullptr)
+			{
+				std::cout << "ļӳʧܣ" << path << std::endl;
+				close();
+				return false;
+			}
+#else
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				std::cout << "޷ļ" << path << std::endl;
+				return false;
+			}
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size < (off_t)min_size || st.st_size == 0)
+			{
+				std::cout << "ļȲ㣬ݲ" << path << std::endl;
+				::close(fd);
+				return false;
+			}
+			length = (std::size_t)st.st_size;
+			void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+			::close(fd);
+			if (p == MAP_FAILED)
+			{
+				std::cout << "ļӳʧܣ" << path << std::endl;
+				length = 0;
+				return false;
+			}
+			base = p;
+#endif
+			return true;
+		}
+
+		//ӳ
+		void close()
+		{
+#ifdef _WIN32
+			if (base != nullptr)
+			{
+				UnmapViewOfFile(base);
+			}
+			if (mapping != nullptr)
+			{
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+			}
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (base != nullptr)
+			{
+				munmap(base, length);
+			}
+#endif
+			base = nullptr;
+			length = 0;
+		}
+
+		//Ƿӳɹ
+		bool is_open() const
+		{
+			return base != nullptr;
+		}
+
+		//ӳʼַҳ
+		const void* data() const
+		{
+			return base;
+		}
+
+		//ļ(ֽ)
+		std::size_t size() const
+		{
+			return length;
+		}
+
+		//ʾϵͳ˳ļǰԤ
+		void will_need() const
+		{
+#ifndef _WIN32
+			if (base != nullptr)
+			{
+				madvise(base, length, MADV_WILLNEED);
+			}
+#endif
+		}
+	};
+
+	//Ѷƾļmmapֻͼ
+	template<typename T>
+	class MappedMatrix
+	{
+	private:
+		int row = 0;//
+		int col = 0;//
+		std::int64_t row_stride = 0;
+		std::int64_t col_stride = 1;
+		const T* data = nullptr;
+		MappedFile file;
+
+		void close()
+		{
+			file.close();
+			data = nullptr;
+			row = 0;
+			col = 0;
+		}
+
+		void take(MappedMatrix& a)
+		{
+			row = a.row;
+			col = a.col;
+			row_stride = a.row_stride;
+			col_stride = a.col_stride;
+			data = a.data;
+			file = std::move(a.file);
+			a.data = nullptr;
+			a.row = 0;
+			a.col = 0;
+		}
+
+	public:
+		//Ĭϳʼ
+		MappedMatrix() {};
+
+		//ӳļ
+		explicit MappedMatrix(const std::string& path)
+		{
+			open(path);
+		}
+
+		MappedMatrix(const MappedMatrix&) = delete;
+		MappedMatrix& operator =(const MappedMatrix&) = delete;
+
+		MappedMatrix(MappedMatrix&& a) noexcept
+		{
+			take(a);
+		}
+
+		MappedMatrix& operator =(MappedMatrix&& a) noexcept
+		{
+			if (this != &a)
+			{
+				close();
+				take(a);
+			}
+			return *this;
+		}
+
+		~MappedMatrix()
+		{
+			close();
+		}
+
+		//ӳļɹtrue
+		bool open(const std::string& path)
+		{
+			close();
+			if (!file.open(path, sizeof(MatrixFileHeader)))
+			{
+				return false;
+			}
+			const MatrixFileHeader* h = static_cast<const MatrixFileHeader*>(file.data());
+			if (!detail::check_header<T>(*h, file.size()) || h->data_offset % alignof(T) != 0)
+			{
+				close();
+				return false;
+			}
+			row = (int)h->rows;
+			col = (int)h->cols;
+			row_stride = h->row_stride;
+			col_stride = h->col_stride;
+			data = reinterpret_cast<const T*>(static_cast<const char*>(file.data()) + h->data_offset);
+			return true;
+		}
+
+		//Ƿӳɹ
+		bool is_open() const
+		{
+			return file.is_open();
+		}
+
+		//
+		int get_row() const
+		{
+			return row;
+		}
+
+		//
+		int get_col() const
+		{
+			return col;
+		}
+
+		//Ƿ(вΪ1)ʱ[]ȡָ
+		bool is_row_contiguous() const
+		{
+			return col_stride == 1;
+		}
+
+		//[]صiеָ룬ҪвΪ1
+		const T* operator [](int i) const
+		{
+			return data + i * row_stride;
+		}
+
+		//ȡ(i, j)Ԫ
+		T at(int i, int j) const
+		{
+			return data[i * row_stride + j * col_stride];
+		}
+
+		//׵ַ
+		const T* get_data() const
+		{
+			return data;
+		}
+
+		//ʾϵͳ˳ǰԤ
+		void will_need() const
+		{
+			file.will_need();
+		}
+
+		//ͨ
+		Matrix2x<T> to_matrix2x() const
+		{
+			Matrix2x<T>ends(row, col);
+			for (int i = 0; i < row; i++)
+			{
+				T* p = ends[i];
+				if (col_stride == 1)
+				{
+					std::memcpy(p, data + i * row_stride, sizeof(T) * col);
+				}
+				else
+				{
+					for (int j = 0; j < col; j++)
+					{
+						p[j] = at(i, j);
+					}
+				}
+			}
+			return ends;
+		}
+	};
+
+	namespace detail
+	{
+		//һʮ"19λЧָ֡"ֱβ10ݣ
+		//β2^5310ݲ1e22ʱstrtodһȷģstrtod
+		//ؽλãʧʱp
+		inline const char* parse_number(const char* p, const char* end, double& out)
+		{
+			static const double pow10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+			const char* s = p;
+			while (s < end && *s == ' ')
+			{
+				s++;
+			}
+			const char* start = s;
+			bool neg = false;
+			if (s < end && (*s == '-' || *s == '+'))
+			{
+				neg = *s == '-';
+				s++;
+			}
+			std::uint64_t mant = 0;
+			int digits = 0;
+			int exp10 = 0;
+			bool any = false;
+			while (s < end && *s >= '0' && *s <= '9')
+			{
+				if (digits < 19)
+				{
+					mant = mant * 10 + (std::uint64_t)(*s - '0');
+					if (mant != 0)
+					{
+						digits++;
+					}
+				}
+				else
+				{
+					exp10++;
+				}
+				any = true;
+				s++;
+			}
+			if (s < end && *s == '.')
+			{
+				s++;
+				while (s < end && *s >= '0' && *s <= '9')
+				{
+					if (digits < 19)
+					{
+						mant = mant * 10 + (std::uint64_t)(*s - '0');
+						if (mant != 0)
+						{
+							digits++;
+						}
+						exp10--;
+					}
+					any = true;
+					s++;
+				}
+			}
+			if (any && s < end && (*s == 'e' || *s == 'E'))
+			{
+				const char* e = s + 1;
+				bool eneg = false;
+				if (e < end && (*e == '-' || *e == '+'))
+				{
+					eneg = *e == '-';
+					e++;
+				}
+				if (e < end && *e >= '0' && *e <= '9')
+				{
+					int ev = 0;
+					while (e < end && *e >= '0' && *e <= '9')
+					{
+						if (ev < 100000)
+						{
+							ev = ev * 10 + (*e - '0');
+						}
+						e++;
+					}
+					exp10 += eneg ? -ev : ev;
+					s = e;
+				}
+			}
+			if (any && mant <= (std::uint64_t(1) << 53) && exp10 >= -22 && exp10 <= 22)
+			{
+				double v = (double)mant;
+				v = exp10 < 0 ? v / pow10[-exp10] : v * pow10[exp10];
+				out = neg ? -v : v;
+				return s;
+			}
+			//·naninfβָ
+			char tmp[128];
+			std::size_t len = 0;
+			const char* q = start;
+			while (q < end && len < sizeof(tmp) - 1 && *q != ',' && *q != '\t' && *q != ';' && *q != '\n' && *q != '\r' && *q != ' ')
+			{
+				tmp[len++] = *q++;
+			}
+			tmp[len] = '\0';
+			char* stop = nullptr;
+			double v = std::strtod(tmp, &stop);
+			if (stop == tmp)
+			{
+				return p;
+			}
+			out = v;
+			return start + (stop - tmp);
+		}
+	}
+
+	//ʽCSV/TSVȡļֱд÷ľ
+	template<typename T>
+	class CsvReader
+	{
+	private:
+		std::FILE* f = nullptr;
+		std::vector<char> buf;
+		std::size_t begin = 0;//ﻹû
+		std::size_t end = 0;//Чյ
+		bool eof = false;
+		char delim;
+		int col = -1;//ɵһݾ
+		long long line_no = 0;//ǰкţ
+
+		static const std::size_t chunk_size = std::size_t(1) << 20;
+
+		//֤һ(Ѿļβ)βλ
+		std::size_t next_line_end()
+		{
+			std::size_t scan = begin;
+			while (true)
+			{
+				const void* nl = scan < end ? std::memchr(buf.data() + scan, '\n', end - scan) : nullptr;
+				if (nl != nullptr)
+				{
+					return (std::size_t)(static_cast<const char*>(nl) - buf.data());
+				}
+				if (eof)
+				{
+					return end;
+				}
+				//ʣµİŲǰ棬ٶһ
+				std::size_t rest = end - begin;
+				if (begin > 0)
+				{
+					std::memmove(buf.data(), buf.data() + begin, rest);
+				}
+				begin = 0;
+				end = rest;
+				scan = rest;
+				if (buf.size() - end < chunk_size)
+				{
+					buf.resize(end + chunk_size);
+				}
+				std::size_t got = std::fread(buf.data() + end, 1, buf.size() - end, f);
+				end += got;
+				if (got == 0)
+				{
+					eof = true;
+				}
+			}
+		}
+
+		//Уfalseʾû
+		bool skip_blank_lines(std::size_t& line_end)
+		{
+			while (true)
+			{
+				line_end = next_line_end();
+				if (begin >= end)
+				{
+					return false;
+				}
+				std::size_t e = line_end;
+				while (e > begin && (buf[e - 1] == '\r' || buf[e - 1] == ' '))
+				{
+					e--;
+				}
+				if (e > begin)
+				{
+					return true;
+				}
+				line_no++;
+				begin = line_end < end ? line_end + 1 : end;
+			}
+		}
+
+	public:
+		//ļdelimΪ',''\t'skip_headerΪtrueʱһ
+		CsvReader(const std::string& path, char delimiter = ',', bool skip_header = false) :delim(delimiter)
+		{
+			f = detail::open_file(path, "rb");
+			if (f == nullptr)
+			{
+				std::cout << "޷ļ" << path << std::endl;
+				return;
+			}
+			buf.resize(chunk_size);
+			std::size_t line_end = 0;
+			if (skip_header && skip_blank_lines(line_end))
+			{
+				line_no++;
+				begin = line_end < end ? line_end + 1 : end;
+			}
+			//ݵһȷ
+			if (skip_blank_lines(line_end))
+			{
+				col = 1;
+				for (std::size_t k = begin; k < line_end; k++)
+				{
+					if (buf[k] == delim)
+					{
+						col++;
+					}
+				}
+			}
+			else
+			{
+				col = 0;
+			}
+		}
+
+		CsvReader(const CsvReader&) = delete;
+		CsvReader& operator =(const CsvReader&) = delete;
+
+		~CsvReader()
+		{
+			if (f != nullptr)
+			{
+				std::fclose(f);
+			}
+		}
+
+		//ļǷ򿪳ɹ
+		bool is_open() const
+		{
+			return f != nullptr;
+		}
+
+		//
+		int get_col() const
+		{
+			return col;
+		}
+
+		//˳chunk.get_row()еchunkʵʶ0ʾ
+		//chunkget_col()Ի޷лᱨ0
+		int read(Matrix2x<T>& chunk)
+		{
+			if (f == nullptr || chunk.get_col() != col)
+			{
+				std::cout << "CSVȡʧЧļǷԼǷļһ" << std::endl;
+				return 0;
+			}
+			int rows = 0;
+			std::size_t line_end = 0;
+			while (rows < chunk.get_row() && skip_blank_lines(line_end))
+			{
+				line_no++;
+				T* out = chunk[rows];
+				const char* p = buf.data() + begin;
+				const char* e = buf.data() + line_end;
+				if (e > p && e[-1] == '\r')
+				{
+					e--;
+				}
+				bool good = true;
+				for (int j = 0; j < col; j++)
+				{
+					double v = 0;
+					const char* q = detail::parse_number(p, e, v);
+					if (q == p)
+					{
+						good = false;
+					}
+					out[j] = (T)v;
+					while (q < e && *q == ' ')
+					{
+						q++;
+					}
+					if (j + 1 < col)
+					{
+						if (q >= e || *q != delim)
+						{
+							good = false;
+							for (int k = j + 1; k < col; k++)
+							{
+								out[k] = T(0);
+							}
+							break;
+						}
+						q++;
+					}
+					p = q;
+				}
+				if (!good || p != e)
+				{
+					std::cout << "CSV" << line_no << "иʽ󣬰0" << std::endl;
+				}
+				begin = line_end < end ? line_end + 1 : end;
+				rows++;
+			}
+			return rows;
+		}
+	};
+
+	//CSV/TSVļһȰһڴ棬һԿ
+	template<typename T>
+	Matrix2x<T> load_csv(const std::string& path, char delimiter = ',', bool skip_header = false)
+	{
+		CsvReader<T> reader(path, delimiter, skip_header);
+		if (!reader.is_open() || reader.get_col() <= 0)
+		{
+			return Matrix2x<T>();
+		}
+		int cols = reader.get_col();
+		Matrix2x<T> chunk(4096, cols);
+		aligned_vector<T> all;
+		int rows = 0;
+		int got = 0;
+		while ((got = reader.read(chunk)) > 0)
+		{
+			all.insert(all.end(), chunk.get_data(), chunk.get_data() + (std::size_t)got * cols);
+			rows += got;
+		}
+		Matrix2x<T>ends(rows, cols);
+		std::copy(all.begin(), all.end(), ends.get_data());
+		return ends;
+	}
+}
+
+#endif // !_EIGEN1_IO_H_
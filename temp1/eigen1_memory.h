@@ -0,0 +1,325 @@
+#pragma once
+#ifndef _EIGEN1_MEMORY_H_
+#define _EIGEN1_MEMORY_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <utility>
+
+#include "eigen1_stats.h"
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+//õڴ
+//1.оݰ64ֽ(һ)룬SIMDͱα
+//2.ÿ߳һСּڴأͷŵڴȻ´ͬСľֱã
+//  ⡢ѵѭﷴͬ״ʱʱϵͳҲᷴȱҳ
+//3.Workspaceinv()gemmҪʱãֻε֮临á
+
+namespace Eigen1
+{
+	//ݵĶֽ
+	const std::size_t memory_align = 64;
+
+	namespace detail
+	{
+		inline void* aligned_malloc(std::size_t bytes)
+		{
+			if (bytes == 0)
+			{
+				bytes = memory_align;
+			}
+#ifdef _MSC_VER
+			void* p = _aligned_malloc(bytes, memory_align);
+#else
+			void* p = nullptr;
+			if (posix_memalign(&p, memory_align, bytes) != 0)
+			{
+				p = nullptr;
+			}
+#endif
+			if (p == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+			return p;
+		}
+
+		inline void aligned_free(void* p)
+		{
+#ifdef _MSC_VER
+			_aligned_free(p);
+#else
+			free(p);
+#endif
+		}
+
+		//ǰ̵߳ڴǷѾ(߳˳ʱ)֮ͷֱӻϵͳ
+		inline bool& pool_dead()
+		{
+			static thread_local bool flag = false;
+			return flag;
+		}
+
+		//2ݷּ߳ڴأkĿС64<<kֽ
+		class SizeClassPool
+		{
+		private:
+			static const int class_count = 26;//һ2GBٴͲ
+			static const int max_cached = 8;//ÿһ໺Ŀ
+			static const std::size_t max_cached_bytes = std::size_t(256) << 20;//ÿ߳໺256MB
+
+			std::vector<void*> free_list[class_count];
+			std::size_t cached_bytes = 0;
+
+		public:
+			SizeClassPool() {};
+			SizeClassPool(const SizeClassPool&) = delete;
+			SizeClassPool& operator =(const SizeClassPool&) = delete;
+
+			~SizeClassPool()
+			{
+				release();
+				pool_dead() = true;
+			}
+
+			//bytesڵļ𣬳һ-1
+			static int size_class(std::size_t bytes)
+			{
+				int k = 0;
+				std::size_t block = memory_align;
+				while (block < bytes)
+				{
+					block <<= 1;
+					k++;
+					if (k >= class_count)
+					{
+						return -1;
+					}
+				}
+				return k;
+			}
+
+			void* allocate(std::size_t bytes)
+			{
+				int k = size_class(bytes);
+				if (k < 0)
+				{
+					EIGEN1_STAT(stat_pool_miss, "pool(oversize)", bytes);
+					return aligned_malloc(bytes);
+				}
+				if (!free_list[k].empty())
+				{
+					void* p = free_list[k].back();
+					free_list[k].pop_back();
+					cached_bytes -= memory_align << k;
+					return p;
+				}
+				EIGEN1_STAT(stat_pool_miss, "pool(empty class)", memory_align << k);
+				return aligned_malloc(memory_align << k);
+			}
+
+			void deallocate(void* p, std::size_t bytes)
+			{
+				int k = size_class(bytes);
+				std::size_t block = k < 0 ? 0 : memory_align << k;
+				if (k < 0 || (int)free_list[k].size() >= max_cached || cached_bytes + block > max_cached_bytes)
+				{
+					aligned_free(p);
+					return;
+				}
+				free_list[k].push_back(p);
+				cached_bytes += block;
+			}
+
+			//ѻĿȫϵͳ
+			void release()
+			{
+				for (int k = 0; k < class_count; k++)
+				{
+					for (void* p : free_list[k])
+					{
+						aligned_free(p);
+					}
+					free_list[k].clear();
+				}
+				cached_bytes = 0;
+			}
+		};
+
+		inline SizeClassPool& local_pool()
+		{
+			static thread_local SizeClassPool pool;
+			return pool;
+		}
+	}
+
+	//ӵǰ̵߳ڴbytesֽڣ64ֽڶ
+	inline void* pool_allocate(std::size_t bytes)
+	{
+		if (detail::pool_dead())
+		{
+			EIGEN1_STAT(stat_pool_miss, "pool(after exit)", bytes);
+			return detail::aligned_malloc(bytes);
+		}
+		return detail::local_pool().allocate(bytes);
+	}
+
+	//ͷpool_allocateõڴ棬bytesʱͬڱ߳ͷ
+	inline void pool_deallocate(void* p, std::size_t bytes)
+	{
+		if (p == nullptr)
+		{
+			return;
+		}
+		if (detail::pool_dead())
+		{
+			detail::aligned_free(p);
+			return;
+		}
+		detail::local_pool().deallocate(p, bytes);
+	}
+
+	//ѵǰ߳ڴﻺĿ黹ϵͳ
+	inline void pool_release()
+	{
+		if (!detail::pool_dead())
+		{
+			detail::local_pool().release();
+		}
+	}
+
+	//ڴصĶֱӸstd::vector
+	template<typename T>
+	class aligned_allocator
+	{
+	public:
+		typedef T value_type;
+
+		aligned_allocator() noexcept {};
+
+		template<typename U>
+		aligned_allocator(const aligned_allocator<U>&) noexcept {};
+
+		T* allocate(std::size_t n)
+		{
+			return static_cast<T*>(pool_allocate(n * sizeof(T)));
+		}
+
+		void deallocate(T* p, std::size_t n) noexcept
+		{
+			pool_deallocate(p, n * sizeof(T));
+		}
+
+		template<typename U>
+		struct rebind
+		{
+			typedef aligned_allocator<U> other;
+		};
+
+		template<typename U>
+		bool operator ==(const aligned_allocator<U>&) const noexcept
+		{
+			return true;
+		}
+
+		template<typename U>
+		bool operator !=(const aligned_allocator<U>&) const noexcept
+		{
+			return false;
+		}
+	};
+
+	//
+	template<typename T>
+	using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+	//ɸõʱÿ(slot)һڴ棬ֻ
+	//ͬ״㷴ʱٷ䡣ͬòͬslot⻥าǡ
+	class Workspace
+	{
+	private:
+		std::vector<std::pair<void*, std::size_t>> blocks;
+
+	public:
+		//ڲռõslotûԼõĴws_userʼ
+		enum slot
+		{
+			ws_inv = 0,
+			ws_gemm_a = 1,
+			ws_gemm_b = 2,
+			ws_solver = 3,
+			ws_quant = 4,
+			ws_reduce = 5,
+			ws_tape = 6,
+			ws_conv = 7,
+			ws_user = 8
+		};
+
+		Workspace() {};
+		Workspace(const Workspace&) = delete;
+		Workspace& operator =(const Workspace&) = delete;
+
+		~Workspace()
+		{
+			release();
+		}
+
+		//صidܷnTĻݲ֤
+		template<typename T>
+		T* get(int id, std::size_t n)
+		{
+			if ((int)blocks.size() <= id)
+			{
+				blocks.resize(id + 1, std::make_pair((void*)nullptr, std::size_t(0)));
+			}
+			std::size_t bytes = n * sizeof(T);
+			if (blocks[id].second < bytes)
+			{
+				//ǳڳеģֱϵͳҪռڴ
+				detail::aligned_free(blocks[id].first);
+				blocks[id].first = nullptr;
+				blocks[id].second = 0;
+				blocks[id].first = detail::aligned_malloc(bytes);
+				EIGEN1_STAT(stat_workspace_grow, "Workspace::get", bytes);
+				blocks[id].second = bytes;
+			}
+			return static_cast<T*>(blocks[id].first);
+		}
+
+		//Ѿеֽ
+		std::size_t capacity() const
+		{
+			std::size_t total = 0;
+			for (const auto& b : blocks)
+			{
+				total += b.second;
+			}
+			return total;
+		}
+
+		//ͷл
+		void release()
+		{
+			for (auto& b : blocks)
+			{
+				detail::aligned_free(b.first);
+				b.first = nullptr;
+				b.second = 0;
+			}
+		}
+
+		//ǰ߳ĬϵĹ
+		static Workspace& local()
+		{
+			static thread_local Workspace ws;
+			return ws;
+		}
+	};
+}
+
+#endif // !_EIGEN1_MEMORY_H_
@@ -0,0 +1,230 @@
+#pragma once
+#ifndef _EIGEN1_PARALLEL_H_
+#define _EIGEN1_PARALLEL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+//򵥵fork-join̳߳أ߳зá
+//߳ڵһõʱ֮һֱãÿ㶼½̡߳
+//ڳ߳ٴεparallel_forֱӴִУ
+//FunctionRef(ֻǶַ)std::functionΪϴlambda϶ѣһ񲻷ڴ档
+
+namespace Eigen1
+{
+	namespace detail
+	{
+		//ӵеĿɵöãַֻһת
+		//õĶýֻҪ
+		template<typename Sig>
+		class FunctionRef;
+
+		template<typename R, typename... Args>
+		class FunctionRef<R(Args...)>
+		{
+		private:
+			const void* obj;
+			R(*call)(const void*, Args...);
+
+			template<typename F>
+			static R invoke(const void* o, Args... args)
+			{
+				return (*static_cast<const F*>(o))(std::forward<Args>(args)...);
+			}
+
+		public:
+			template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, FunctionRef>::value>::type>
+			FunctionRef(const F& f) :obj(&f), call(&invoke<F>) {};
+
+			R operator ()(Args... args) const
+			{
+				return call(obj, std::forward<Args>(args)...);
+			}
+		};
+
+		class ThreadPool
+		{
+		private:
+			std::vector<std::thread> workers;
+			std::mutex m;
+			std::condition_variable start_cv;
+			std::condition_variable done_cv;
+			std::mutex run_mutex;//ͬһʱֻһռ̳߳
+
+			const FunctionRef<void(int)>* job = nullptr;
+			int job_count = 0;//ķ
+			int job_next = 0;//һݻûߵ
+			int job_remaining = 0;//ûķ
+			unsigned long long generation = 0;
+			bool stop = false;
+
+			ThreadPool()
+			{
+				int n = (int)std::thread::hardware_concurrency();
+				if (n < 1)
+				{
+					n = 1;
+				}
+				for (int i = 0; i < n - 1; i++)
+				{
+					workers.emplace_back([this]() { this->worker_loop(); });
+				}
+			}
+
+			void worker_loop()
+			{
+				in_pool() = true;
+				unsigned long long seen = 0;
+				std::unique_lock<std::mutex> lk(m);
+				while (true)
+				{
+					start_cv.wait(lk, [&]() { return stop || generation != seen; });
+					if (stop)
+					{
+						return;
+					}
+					seen = generation;
+					while (job_next < job_count)
+					{
+						int id = job_next++;
+						lk.unlock();
+						(*job)(id);
+						lk.lock();
+						if (--job_remaining == 0)
+						{
+							done_cv.notify_all();
+						}
+					}
+				}
+			}
+
+		public:
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator =(const ThreadPool&) = delete;
+
+			~ThreadPool()
+			{
+				{
+					std::lock_guard<std::mutex> lk(m);
+					stop = true;
+				}
+				start_cv.notify_all();
+				for (std::thread& t : workers)
+				{
+					t.join();
+				}
+			}
+
+			static ThreadPool& instance()
+			{
+				static ThreadPool pool;
+				return pool;
+			}
+
+			//ǰ߳ǷǳĹ߳
+			static bool& in_pool()
+			{
+				static thread_local bool flag = false;
+				return flag;
+			}
+
+			//߳ϵ̱߳
+			int size() const
+			{
+				return (int)workers.size() + 1;
+			}
+
+			//f(0), f(1), ..., f(n-1)ִָ߳У߳Ҳ룬ȫŷ
+			void run(int n, const FunctionRef<void(int)>& f)
+			{
+				if (n <= 1 || workers.empty() || in_pool())
+				{
+					for (int i = 0; i < n; i++)
+					{
+						f(i);
+					}
+					return;
+				}
+				std::lock_guard<std::mutex> run_lk(run_mutex);
+				in_pool() = true;
+				std::unique_lock<std::mutex> lk(m);
+				job = &f;
+				job_count = n;
+				job_next = 0;
+				job_remaining = n;
+				generation++;
+				start_cv.notify_all();
+				while (job_next < job_count)
+				{
+					int id = job_next++;
+					lk.unlock();
+					f(id);
+					lk.lock();
+					--job_remaining;
+				}
+				done_cv.wait(lk, [&]() { return job_remaining == 0; });
+				job = nullptr;
+				in_pool() = false;
+			}
+		};
+
+		inline std::atomic<int>& num_threads_setting()
+		{
+			static std::atomic<int> n(0);
+			return n;
+		}
+	}
+
+	//þʹõ߳0ʾʹȫӲ߳
+	inline void set_num_threads(int n)
+	{
+		detail::num_threads_setting() = n < 0 ? 0 : n;
+	}
+
+	//ؾʵʹõ߳
+	inline int get_num_threads()
+	{
+		int n = detail::num_threads_setting();
+		int all = detail::ThreadPool::instance().size();
+		return (n == 0 || n > all) ? all : n;
+	}
+
+	//f(0), ..., f(n-1)ִУһnȡget_num_threads()ÿԼһ
+	inline void parallel_run(int n, detail::FunctionRef<void(int)> f)
+	{
+		detail::ThreadPool::instance().run(n, f);
+	}
+
+	//[begin, end)grainп鲢ִf(, յ)̫Сʱֱڵǰ߳
+	inline void parallel_for(long long begin, long long end, long long grain, detail::FunctionRef<void(long long, long long)> f)
+	{
+		long long total = end - begin;
+		if (total <= 0)
+		{
+			return;
+		}
+		if (grain < 1)
+		{
+			grain = 1;
+		}
+		long long parts = std::min<long long>(get_num_threads(), (total + grain - 1) / grain);
+		if (parts <= 1)
+		{
+			f(begin, end);
+			return;
+		}
+		parallel_run((int)parts, [&](int id) {
+			long long lo = begin + total * id / parts;
+			long long hi = begin + total * (id + 1) / parts;
+			f(lo, hi);
+		});
+	}
+}
+
+#endif // !_EIGEN1_PARALLEL_H_
@@ -0,0 +1,576 @@
+#pragma once
+#ifndef _EIGEN1_QUANT_H_
+#define _EIGEN1_QUANT_H_
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define EIGEN1_QUANT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+//SIMDں˸԰Ŀָ룬̱/archGCC/Clangtargetԣ
+//MSVCڽ/archƣע
+#if defined(EIGEN1_QUANT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define EIGEN1_QUANT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define EIGEN1_QUANT_TARGET(isa)
+#endif
+
+//ʶVNNIڽűVNNIںˣGCC 11Clang 12VS2022
+#if defined(EIGEN1_QUANT_X86) && ((defined(__clang__) && __clang_major__ >= 12) || (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 11) || (defined(_MSC_VER) && _MSC_VER >= 1930))
+#define EIGEN1_QUANT_VNNI
+#endif
+
+#include "eigen1.h"
+#include "eigen1_memory.h"
+#include "eigen1_parallel.h"
+
+//int8õľ˷
+//Գq = round(x / scale)ȡֵ[-127, 127]scale = max|x| / 127һscaleҲÿһ
+//˷ C = A * B^TABǰint8ۼint32Ȩһת(quantize_transposed)
+//BÿһжӦһͨkģʺϰ8λ
+//ںʱcpuidѡ֧AVX-VNNIAVX512-VNNIʱvpdpbusd֧AVX2ʱvpmaddubsw + vpmaddwd
+//ͨѭѡеں˻ںָͬһ±ϻ»ܡ
+//Էɸ(˳ƫ)Ҳֱint8һá
+
+namespace Eigen1
+{
+	//
+	enum class QuantMode
+	{
+		per_tensor,//һscale
+		per_row//ÿһscale
+	};
+
+	namespace detail
+	{
+		//ÿа32ֽڲ룬SIMDѭôβͣλ0
+		const int quant_pad = 32;
+
+		//һδAǵint32ȷڹȫβ
+		const int quant_row_block = 16;
+
+		//ab0~b3ĵnquant_padдout[0..3]
+		typedef void (*dot4_fn)(const int8_t* a, const int8_t* b0, const int8_t* b1, const int8_t* b2, const int8_t* b3, int n, int32_t* out);
+
+		//ͨѭκλãҲǼSIMDں˵Ļ׼
+		inline void dot4_s8_scalar(const int8_t* a, const int8_t* b0, const int8_t* b1, const int8_t* b2, const int8_t* b3, int n, int32_t* out)
+		{
+			int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+			for (int k = 0; k < n; k++)
+			{
+				int32_t av = a[k];
+				s0 += av * b0[k];
+				s1 += av * b1[k];
+				s2 += av * b2[k];
+				s3 += av * b3[k];
+			}
+			out[0] = s0;
+			out[1] = s1;
+			out[2] = s2;
+			out[3] = s3;
+		}
+
+#ifdef EIGEN1_QUANT_X86
+		//4int32ۼԺ
+		EIGEN1_QUANT_TARGET("avx2")
+		inline void hsum4_s32(const __m256i* acc, int32_t* out)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				__m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc[r]), _mm256_extracti128_si256(acc[r], 1));
+				s = _mm_hadd_epi32(s, s);
+				s = _mm_hadd_epi32(s, s);
+				out[r] = _mm_cvtsi128_si32(s);
+			}
+		}
+
+		//u8*s8ָҪһ޷ţ|a|ϴaŵb˻䡣
+		//Գû-128|a|*|b|127*127Ҳ16λ
+		EIGEN1_QUANT_TARGET("avx2")
+		inline void dot4_s8_avx2(const int8_t* a, const int8_t* b0, const int8_t* b1, const int8_t* b2, const int8_t* b3, int n, int32_t* out)
+		{
+			const int8_t* b[4] = { b0, b1, b2, b3 };
+			__m256i acc[4];
+			for (int r = 0; r < 4; r++)
+			{
+				acc[r] = _mm256_setzero_si256();
+			}
+			const __m256i ones = _mm256_set1_epi16(1);
+			for (int k = 0; k < n; k += 32)
+			{
+				__m256i va = _mm256_loadu_si256((const __m256i*)(a + k));
+				__m256i ua = _mm256_abs_epi8(va);
+				for (int r = 0; r < 4; r++)
+				{
+					__m256i vb = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i*)(b[r] + k)), va);
+					acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(_mm256_maddubs_epi16(ua, vb), ones));
+				}
+			}
+			hsum4_s32(acc, out);
+			_mm256_zeroupper();
+		}
+
+#ifdef EIGEN1_QUANT_VNNI
+		//ͬϣ˼һvpdpbusd(VEX룬Alder LakeAVX-VNNI)
+		EIGEN1_QUANT_TARGET("avx2,avxvnni")
+		inline void dot4_s8_avxvnni(const int8_t* a, const int8_t* b0, const int8_t* b1, const int8_t* b2, const int8_t* b3, int n, int32_t* out)
+		{
+			const int8_t* b[4] = { b0, b1, b2, b3 };
+			__m256i acc[4];
+			for (int r = 0; r < 4; r++)
+			{
+				acc[r] = _mm256_setzero_si256();
+			}
+			for (int k = 0; k < n; k += 32)
+			{
+				__m256i va = _mm256_loadu_si256((const __m256i*)(a + k));
+				__m256i ua = _mm256_abs_epi8(va);
+				for (int r = 0; r < 4; r++)
+				{
+					__m256i vb = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i*)(b[r] + k)), va);
+					acc[r] = _mm256_dpbusd_avx_epi32(acc[r], ua, vb);
+				}
+			}
+			hsum4_s32(acc, out);
+			_mm256_zeroupper();
+		}
+
+		//ͬϣEVEX256λvpdpbusd(Ice LakeZen4ȴAVX512-VNNIĻ)
+		EIGEN1_QUANT_TARGET("avx2,avx512vnni,avx512vl")
+		inline void dot4_s8_avx512vnni(const int8_t* a, const int8_t* b0, const int8_t* b1, const int8_t* b2, const int8_t* b3, int n, int32_t* out)
+		{
+			const int8_t* b[4] = { b0, b1, b2, b3 };
+			__m256i acc[4];
+			for (int r = 0; r < 4; r++)
+			{
+				acc[r] = _mm256_setzero_si256();
+			}
+			for (int k = 0; k < n; k += 32)
+			{
+				__m256i va = _mm256_loadu_si256((const __m256i*)(a + k));
+				__m256i ua = _mm256_abs_epi8(va);
+				for (int r = 0; r < 4; r++)
+				{
+					__m256i vb = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i*)(b[r] + k)), va);
+					acc[r] = _mm256_dpbusd_epi32(acc[r], ua, vb);
+				}
+			}
+			hsum4_s32(acc, out);
+			_mm256_zeroupper();
+		}
+#endif
+
+		//cpuid(leaf, sub)eaxebxecxedxŽr
+		inline void cpuid(unsigned int leaf, unsigned int sub, unsigned int r[4])
+		{
+#ifdef _MSC_VER
+			int v[4];
+			__cpuidex(v, (int)leaf, (int)sub);
+			for (int i = 0; i < 4; i++)
+			{
+				r[i] = (unsigned int)v[i];
+			}
+#else
+			__cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+		}
+
+		//ϵͳЩĴ״̬(XCR0)
+		inline unsigned long long xgetbv0()
+		{
+#ifdef _MSC_VER
+			return _xgetbv(0);
+#else
+			unsigned int lo, hi;
+			__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			return ((unsigned long long)hi << 32) | lo;
+#endif
+		}
+#endif
+
+		//CPUͲϵͳֵ֧ĵָ
+		struct QuantCpu
+		{
+			bool avx2 = false;
+			bool avx_vnni = false;
+			bool avx512_vnni = false;
+		};
+
+		inline QuantCpu detect_quant_cpu()
+		{
+			QuantCpu f;
+#ifdef EIGEN1_QUANT_X86
+			unsigned int r[4];
+			cpuid(0, 0, r);
+			unsigned int max_leaf = r[0];
+			if (max_leaf < 7)
+			{
+				return f;
+			}
+			cpuid(1, 0, r);
+			//OSXSAVEAVXλڲܶXCR0
+			if (((r[2] >> 27) & 1) == 0 || ((r[2] >> 28) & 1) == 0)
+			{
+				return f;
+			}
+			unsigned long long xcr0 = xgetbv0();
+			bool ymm = (xcr0 & 0x6) == 0x6;
+			bool zmm = (xcr0 & 0xe6) == 0xe6;
+			cpuid(7, 0, r);
+			unsigned int max_sub = r[0];
+			f.avx2 = ymm && ((r[1] >> 5) & 1);
+			//AVX512FAVX512VLAVX512-VNNI
+			f.avx512_vnni = f.avx2 && zmm && ((r[1] >> 16) & 1) && ((r[1] >> 31) & 1) && ((r[2] >> 11) & 1);
+			if (max_sub >= 1)
+			{
+				cpuid(7, 1, r);
+				f.avx_vnni = f.avx2 && ((r[0] >> 4) & 1);
+			}
+#endif
+			return f;
+		}
+
+		//һںˣsupportedʾܲ
+		struct Dot4Kernel
+		{
+			const char* name;
+			dot4_fn fn;
+			bool supported;
+		};
+
+		//ȫںˣȼӸߵͣһͨѭ
+		inline std::vector<Dot4Kernel> dot4_kernels()
+		{
+			QuantCpu cpu = detect_quant_cpu();
+			std::vector<Dot4Kernel> ends;
+#ifdef EIGEN1_QUANT_X86
+#ifdef EIGEN1_QUANT_VNNI
+			ends.push_back({ "avx-vnni", dot4_s8_avxvnni, cpu.avx_vnni });
+			ends.push_back({ "avx512-vnni", dot4_s8_avx512vnni, cpu.avx512_vnni });
+#endif
+			ends.push_back({ "avx2", dot4_s8_avx2, cpu.avx2 });
+#endif
+			ends.push_back({ "scalar", dot4_s8_scalar, true });
+			(void)cpu;
+			return ends;
+		}
+
+		//һεʱѡܵںˣֱ֮ӷ
+		inline const Dot4Kernel& dot4_kernel()
+		{
+			static const Dot4Kernel chosen = []() {
+				std::vector<Dot4Kernel> all = dot4_kernels();
+				for (const Dot4Kernel& k : all)
+				{
+					if (k.supported)
+					{
+						return k;
+					}
+				}
+				return all.back();
+			}();
+			return chosen;
+		}
+
+		//xint8
+		inline int8_t quantize_value(double x, double inv_scale)
+		{
+			double q = std::round(x * inv_scale);
+			q = q > 127.0 ? 127.0 : (q < -127.0 ? -127.0 : q);
+			return (int8_t)q;
+		}
+	}
+
+	//Գint8
+	class QuantizedMatrix
+	{
+	private:
+		int row = 0;
+		int col = 0;
+		int stride = 0;//ÿʵռֽcolquant_pad
+		QuantMode mode = QuantMode::per_row;
+		aligned_vector<int8_t> data;
+		std::vector<float> scale;//per_tensorʱֻһ
+
+	public:
+		QuantizedMatrix() {};
+
+		//״䣬㣬scale1еڴ湻ʱ·
+		void reshape(int size_row, int size_col, QuantMode quant_mode)
+		{
+			row = size_row;
+			col = size_col;
+			stride = (size_col + detail::quant_pad - 1) / detail::quant_pad * detail::quant_pad;
+			mode = quant_mode;
+			data.assign((std::size_t)row * stride, 0);
+			scale.assign(mode == QuantMode::per_row ? row : 1, 1.0f);
+		}
+
+		int get_row() const
+		{
+			return row;
+		}
+
+		int get_col() const
+		{
+			return col;
+		}
+
+		int get_stride() const
+		{
+			return stride;
+		}
+
+		QuantMode get_mode() const
+		{
+			return mode;
+		}
+
+		//iе׵ַ
+		int8_t* operator [](int i)
+		{
+			return data.data() + (std::size_t)i * stride;
+		}
+		const int8_t* operator [](int i) const
+		{
+			return data.data() + (std::size_t)i * stride;
+		}
+
+		//iеscale
+		float get_scale(int i) const
+		{
+			return mode == QuantMode::per_row ? scale[i] : scale[0];
+		}
+		void set_scale(int i, float s)
+		{
+			scale[mode == QuantMode::per_row ? i : 0] = s;
+		}
+
+		//ظ
+		template<typename T>
+		Matrix2x<T> dequantize() const
+		{
+			Matrix2x<T>ends(row, col);
+			for (int i = 0; i < row; i++)
+			{
+				const int8_t* q = (*this)[i];
+				T s = (T)get_scale(i);
+				T* p = ends[i];
+				for (int j = 0; j < col; j++)
+				{
+					p[j] = s * (T)q[j];
+				}
+			}
+			return ends;
+		}
+	};
+
+	namespace detail
+	{
+		//src(iеjеԪget(i, j))per_tensorʱȫֵ
+		template<typename F>
+		void quantize_rows(int row, int col, QuantMode mode, F get, QuantizedMatrix& out)
+		{
+			out.reshape(row, col, mode);
+			double global = 0;
+			if (mode == QuantMode::per_tensor)
+			{
+				for (int i = 0; i < row; i++)
+				{
+					for (int j = 0; j < col; j++)
+					{
+						global = std::max(global, std::abs((double)get(i, j)));
+					}
+				}
+				out.set_scale(0, global > 0 ? (float)(global / 127.0) : 1.0f);
+			}
+			parallel_for(0, row, 16, [&](long long lo, long long hi) {
+				for (long long i = lo; i < hi; i++)
+				{
+					double m = global;
+					if (mode == QuantMode::per_row)
+					{
+						m = 0;
+						for (int j = 0; j < col; j++)
+						{
+							m = std::max(m, std::abs((double)get((int)i, j)));
+						}
+						out.set_scale((int)i, m > 0 ? (float)(m / 127.0) : 1.0f);
+					}
+					double inv = 1.0 / out.get_scale((int)i);
+					int8_t* q = out[(int)i];
+					for (int j = 0; j < col; j++)
+					{
+						q[j] = quantize_value((double)get((int)i, j), inv);
+					}
+				}
+			});
+		}
+
+		//int8˷ѭc = a * b^Tÿquant_row_blockоͶ⼸еepilogue(i, һеint32)
+		template<typename F>
+		void gemm_s8_rows(const QuantizedMatrix& a, const QuantizedMatrix& b, F epilogue)
+		{
+			int m = a.get_row();
+			int n = b.get_row();
+			int k = a.get_stride();
+			//bһԼ128KBL2⼸a
+			int tile = std::max(4, (131072 / std::max(k, 1)) / 4 * 4);
+			const dot4_fn dot4_s8 = dot4_kernel().fn;
+			parallel_for(0, m, quant_row_block, [&](long long lo, long long hi) {
+				int32_t* c = Workspace::local().get<int32_t>(Workspace::ws_quant, (std::size_t)quant_row_block * (n + 3));
+				for (long long i0 = lo; i0 < hi; i0 += quant_row_block)
+				{
+					int rows = (int)std::min<long long>(quant_row_block, hi - i0);
+					for (int j0 = 0; j0 < n; j0 += tile)
+					{
+						int j1 = std::min(n, j0 + tile);
+						for (int r = 0; r < rows; r++)
+						{
+							const int8_t* pa = a[(int)i0 + r];
+							int32_t* pc = c + (std::size_t)r * (n + 3);
+							int j = j0;
+							for (; j + 4 <= j1; j += 4)
+							{
+								dot4_s8(pa, b[j], b[j + 1], b[j + 2], b[j + 3], k, pc + j);
+							}
+							if (j < j1)
+							{
+								//4ʱظһдչĽдڲ3λ
+								const int8_t* bl = b[j1 - 1];
+								dot4_s8(pa, b[j], j + 1 < j1 ? b[j + 1] : bl, j + 2 < j1 ? b[j + 2] : bl, bl, k, pc + j);
+							}
+						}
+					}
+					for (int r = 0; r < rows; r++)
+					{
+						epilogue((int)i0 + r, (const int32_t*)(c + (std::size_t)r * (n + 3)));
+					}
+				}
+			});
+		}
+	}
+
+	//󣬽дoutoutеڴ湻ʱ·
+	template<typename T>
+	void quantize(const Matrix2x<T>& m, QuantMode mode, QuantizedMatrix& out)
+	{
+		detail::quantize_rows(m.get_row(), m.get_col(), mode, [&](int i, int j) { return m[i][j]; }, out);
+	}
+
+	template<typename T>
+	QuantizedMatrix quantize(const Matrix2x<T>& m, QuantMode mode)
+	{
+		QuantizedMatrix ends;
+		quantize(m, mode, ends);
+		return ends;
+	}
+
+	//mתáDenseȨ(in x out)תúÿһͨper_rowǰͨ
+	template<typename T>
+	QuantizedMatrix quantize_transposed(const Matrix2x<T>& m, QuantMode mode)
+	{
+		QuantizedMatrix ends;
+		detail::quantize_rows(m.get_col(), m.get_row(), mode, [&](int i, int j) { return m[j][i]; }, ends);
+		return ends;
+	}
+
+	//int8˷ʵõĵں("avx-vnni""avx512-vnni""avx2""scalar")
+	inline const char* quant_kernel_name()
+	{
+		return detail::dot4_kernel().name;
+	}
+
+	//int8˷ֻҪint32c = a * b^Tc(a.row x b.row)
+	inline void gemm_s8(const QuantizedMatrix& a, const QuantizedMatrix& b, std::vector<int32_t>& c)
+	{
+		if (a.get_col() != b.get_col())
+		{
+			std::cout << "int8˷ʧЧǷͬ" << std::endl;
+			return;
+		}
+		int n = b.get_row();
+		c.resize((std::size_t)a.get_row() * n);
+		detail::gemm_s8_rows(a, b, [&](int i, const int32_t* pc) {
+			std::copy_n(pc, n, c.data() + (std::size_t)i * n);
+		});
+	}
+
+	//int8˷ٷout = (a * b^T)ߵscaleԭ + biasbiasΪ
+	template<typename T>
+	void gemm_dequant(const QuantizedMatrix& a, const QuantizedMatrix& b, const T* bias, Matrix2x<T>& out)
+	{
+		if (a.get_col() != b.get_col())
+		{
+			std::cout << "int8˷ʧЧǷͬ" << std::endl;
+			return;
+		}
+		int n = b.get_row();
+		if (out.get_row() != a.get_row() || out.get_col() != n)
+		{
+			out.resize(a.get_row(), n);
+		}
+		detail::gemm_s8_rows(a, b, [&](int i, const int32_t* pc) {
+			T sa = (T)a.get_scale(i);
+			T* po = out[i];
+			for (int j = 0; j < n; j++)
+			{
+				T v = sa * (T)b.get_scale(j) * (T)pc[j];
+				po[j] = bias != nullptr ? v + bias[j] : v;
+			}
+		});
+	}
+
+	//int8˷ֱint8һãbiasΪա
+	//out_scale > 0 ʱ̶scale(ȱ궨)ÿаһеֵȡscale
+	inline void gemm_requant(const QuantizedMatrix& a, const QuantizedMatrix& b, const float* bias, float out_scale, QuantizedMatrix& out)
+	{
+		if (a.get_col() != b.get_col())
+		{
+			std::cout << "int8˷ʧЧǷͬ" << std::endl;
+			return;
+		}
+		int n = b.get_row();
+		out.reshape(a.get_row(), n, out_scale > 0 ? QuantMode::per_tensor : QuantMode::per_row);
+		if (out_scale > 0)
+		{
+			out.set_scale(0, out_scale);
+		}
+		detail::gemm_s8_rows(a, b, [&](int i, const int32_t* pc) {
+			float sa = a.get_scale(i);
+			auto value = [&](int j) {
+				float v = sa * b.get_scale(j) * (float)pc[j];
+				return bias != nullptr ? v + bias[j] : v;
+			};
+			if (out_scale <= 0)
+			{
+				//̬scaleҪɨһһֵڶһηֵ
+				double m = 0;
+				for (int j = 0; j < n; j++)
+				{
+					m = std::max(m, std::abs((double)value(j)));
+				}
+				out.set_scale(i, m > 0 ? (float)(m / 127.0) : 1.0f);
+			}
+			double inv = 1.0 / out.get_scale(i);
+			int8_t* q = out[i];
+			for (int j = 0; j < n; j++)
+			{
+				q[j] = detail::quantize_value(value(j), inv);
+			}
+		});
+	}
+}
+
+#endif // !_EIGEN1_QUANT_H_
@@ -0,0 +1,487 @@
+#pragma once
+#ifndef _EIGEN1_REDUCE_H_
+#define _EIGEN1_REDUCE_H_
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+
+#include "eigen1.h"
+#include "eigen1_memory.h"
+#include "eigen1_parallel.h"
+
+//Matrix2xĹԼ(ֵ͡Сֵ/)͹㲥(ÿмͬһ)
+//1.ݵóɶͣ256Ԫ8·ۼ(ֱ)ÿζ԰ֵݹ飬
+//  泤Ȱlog(n)˳ۼӵn
+//2.һһ¼ӣKahanͣڲзͬ
+//3.ʱ߳п飬ÿԹԼѸĽϲ(ιԼ)
+//ע⣺/fp:fast-ffast-mathʱܰKahanĲŻ
+
+namespace Eigen1
+{
+	namespace detail
+	{
+		//ɶ͵Ҷӳ
+		const std::size_t reduce_block = 256;
+
+		//Ԫظﵽſ߳
+		const std::size_t reduce_parallel = std::size_t(1) << 16;
+
+		//sum(f(p[k]))ɶ
+		template<typename T, typename F>
+		T pairwise_sum(const T* p, std::size_t n, F f)
+		{
+			if (n <= reduce_block)
+			{
+				T acc[8] = {};
+				std::size_t k = 0;
+				for (; k + 8 <= n; k += 8)
+				{
+					for (int j = 0; j < 8; j++)
+					{
+						acc[j] += f(p[k + j]);
+					}
+				}
+				T tail = 0;
+				for (; k < n; k++)
+				{
+					tail += f(p[k]);
+				}
+				return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7])) + tail;
+			}
+			std::size_t half = n / 2 / 8 * 8;
+			return pairwise_sum(p, half, f) + pairwise_sum(p + half, n - half, f);
+		}
+
+		//8·еopԼ(maxmin)initǵλԪ
+		template<typename T, typename F, typename Op>
+		T lane_reduce(const T* p, std::size_t n, T init, F f, Op op)
+		{
+			T acc[8];
+			for (int j = 0; j < 8; j++)
+			{
+				acc[j] = init;
+			}
+			std::size_t k = 0;
+			for (; k + 8 <= n; k += 8)
+			{
+				for (int j = 0; j < 8; j++)
+				{
+					acc[j] = op(acc[j], f(p[k + j]));
+				}
+			}
+			T ends = init;
+			for (; k < n; k++)
+			{
+				ends = op(ends, f(p[k]));
+			}
+			for (int j = 0; j < 8; j++)
+			{
+				ends = op(ends, acc[j]);
+			}
+			return ends;
+		}
+
+		//nԪؾָ̣߳ÿleafԼϲ
+		template<typename T, typename Leaf, typename Op>
+		T parallel_reduce(std::size_t n, T init, Leaf leaf, Op op)
+		{
+			int parts = get_num_threads();
+			if (n < reduce_parallel || parts <= 1)
+			{
+				return leaf(std::size_t(0), n);
+			}
+			T* partial = Workspace::local().get<T>(Workspace::ws_reduce, parts);
+			std::fill_n(partial, parts, init);
+			std::size_t chunk = (n + parts - 1) / parts;
+			parallel_run(parts, [&](int id) {
+				std::size_t lo = (std::size_t)id * chunk;
+				std::size_t hi = std::min(n, lo + chunk);
+				if (lo < hi)
+				{
+					partial[id] = leaf(lo, hi);
+				}
+			});
+			for (int step = 1; step < parts; step *= 2)
+			{
+				for (int i = 0; i + step < parts; i += 2 * step)
+				{
+					partial[i] = op(partial[i], partial[i + step]);
+				}
+			}
+			return partial[0];
+		}
+
+		template<typename T, typename F>
+		T reduce_sum(const Matrix2x<T>& m, F f)
+		{
+			const T* p = m.get_data();
+			return parallel_reduce(m.size(), T(0), [&](std::size_t lo, std::size_t hi) { return pairwise_sum(p + lo, hi - lo, f); },
+				[](T a, T b) { return a + b; });
+		}
+
+		template<typename T, typename F, typename Op>
+		T reduce_lanes(const Matrix2x<T>& m, T init, F f, Op op)
+		{
+			const T* p = m.get_data();
+			return parallel_reduce(m.size(), init, [&](std::size_t lo, std::size_t hi) { return lane_reduce(p + lo, hi - lo, init, f, op); }, op);
+		}
+
+		//[r0, r1)аKahanͣۼӵsum/comp
+		template<typename T>
+		void kahan_col_sum(const Matrix2x<T>& m, int r0, int r1, T* sum, T* comp)
+		{
+			int col = m.get_col();
+			for (int i = r0; i < r1; i++)
+			{
+				const T* p = m[i];
+				for (int j = 0; j < col; j++)
+				{
+					T y = p[j] - comp[j];
+					T t = sum[j] + y;
+					comp[j] = (t - sum[j]) - y;
+					sum[j] = t;
+				}
+			}
+		}
+
+		//Ѳ(sum_b, comp_b)(sum_a, comp_a)ʵֵ sum - comp 㣬
+		//TwoSumߵĲһcompںϲʱ
+		template<typename T>
+		void kahan_merge(T* sum_a, T* comp_a, const T* sum_b, const T* comp_b, int col)
+		{
+			for (int j = 0; j < col; j++)
+			{
+				T t = sum_a[j] + sum_b[j];
+				T bv = t - sum_a[j];
+				T err = (sum_a[j] - (t - bv)) + (sum_b[j] - bv);
+				comp_a[j] = (comp_a[j] + comp_b[j]) - err;
+				sum_a[j] = t;
+			}
+		}
+
+		template<typename T>
+		struct identity_op
+		{
+			T operator ()(T x) const
+			{
+				return x;
+			}
+		};
+
+		template<typename T>
+		struct abs_op
+		{
+			T operator ()(T x) const
+			{
+				return std::abs(x);
+			}
+		};
+
+		template<typename T>
+		struct square_op
+		{
+			T operator ()(T x) const
+			{
+				return x * x;
+			}
+		};
+
+		template<typename T>
+		struct max_op
+		{
+			T operator ()(T a, T b) const
+			{
+				return a < b ? b : a;
+			}
+		};
+
+		template<typename T>
+		struct min_op
+		{
+			T operator ()(T a, T b) const
+			{
+				return b < a ? b : a;
+			}
+		};
+	}
+
+	//Ԫ֮
+	template<typename T>
+	T sum(const Matrix2x<T>& m)
+	{
+		return detail::reduce_sum(m, detail::identity_op<T>());
+	}
+
+	//Ԫصľֵ
+	template<typename T>
+	T mean(const Matrix2x<T>& m)
+	{
+		if (m.size() == 0)
+		{
+			std::cout << "վûоֵ" << std::endl;
+			return T(0);
+		}
+		return sum(m) / T(m.size());
+	}
+
+	//Ԫ
+	template<typename T>
+	T max_coeff(const Matrix2x<T>& m)
+	{
+		return detail::reduce_lanes(m, std::numeric_limits<T>::lowest(), detail::identity_op<T>(), detail::max_op<T>());
+	}
+
+	//СԪ
+	template<typename T>
+	T min_coeff(const Matrix2x<T>& m)
+	{
+		return detail::reduce_lanes(m, std::numeric_limits<T>::max(), detail::identity_op<T>(), detail::min_op<T>());
+	}
+
+	//ƽ sum(x^2)ֱӳɶۼƽsqrtƽ
+	template<typename T>
+	T squared_norm(const Matrix2x<T>& m)
+	{
+		return detail::reduce_sum(m, detail::square_op<T>());
+	}
+
+	//Frobenius sqrt(sum(x^2))
+	template<typename T>
+	T norm(const Matrix2x<T>& m)
+	{
+		return std::sqrt(squared_norm(m));
+	}
+
+	//Ԫؾֵ֮
+	template<typename T>
+	T norm1(const Matrix2x<T>& m)
+	{
+		return detail::reduce_sum(m, detail::abs_op<T>());
+	}
+
+	//ֵ
+	template<typename T>
+	T norm_inf(const Matrix2x<T>& m)
+	{
+		return detail::reduce_lanes(m, T(0), detail::abs_op<T>(), detail::max_op<T>());
+	}
+
+	//ÿͣout(row x 1)״ʱ·
+	template<typename T>
+	void row_sum(const Matrix2x<T>& m, Matrix2x<T>& out)
+	{
+		if (out.get_row() != m.get_row() || out.get_col() != 1)
+		{
+			out.resize(m.get_row(), 1);
+		}
+		int col = m.get_col();
+		T* po = out.get_data();
+		parallel_for(0, m.get_row(), std::max<long long>(1, (long long)(detail::reduce_parallel / std::max(col, 1))), [&](long long lo, long long hi) {
+			for (long long i = lo; i < hi; i++)
+			{
+				po[i] = detail::pairwise_sum(m[(int)i], (std::size_t)col, detail::identity_op<T>());
+			}
+		});
+	}
+
+	template<typename T>
+	Matrix2x<T> row_sum(const Matrix2x<T>& m)
+	{
+		Matrix2x<T>ends;
+		row_sum(m, ends);
+		return ends;
+	}
+
+	//ÿеֵout(row x 1)
+	template<typename T>
+	void row_max(const Matrix2x<T>& m, Matrix2x<T>& out)
+	{
+		if (out.get_row() != m.get_row() || out.get_col() != 1)
+		{
+			out.resize(m.get_row(), 1);
+		}
+		int col = m.get_col();
+		T* po = out.get_data();
+		parallel_for(0, m.get_row(), std::max<long long>(1, (long long)(detail::reduce_parallel / std::max(col, 1))), [&](long long lo, long long hi) {
+			for (long long i = lo; i < hi; i++)
+			{
+				po[i] = detail::lane_reduce(m[(int)i], (std::size_t)col, std::numeric_limits<T>::lowest(), detail::identity_op<T>(), detail::max_op<T>());
+			}
+		});
+	}
+
+	//ÿͣout(1 x col)accumulateΪtrueʱӵoutԭֵ(ƫõݶ)
+	template<typename T>
+	void col_sum(const Matrix2x<T>& m, Matrix2x<T>& out, bool accumulate = false)
+	{
+		int row = m.get_row();
+		int col = m.get_col();
+		if (out.get_row() != 1 || out.get_col() != col)
+		{
+			if (accumulate)
+			{
+				std::cout << "ۼʧЧ״ǷΪ(1 x )" << std::endl;
+				return;
+			}
+			out.resize(1, col);
+		}
+		T* po = out.get_data();
+		int parts = get_num_threads();
+		if (m.size() < detail::reduce_parallel || parts <= 1 || row < 2 * parts)
+		{
+			T* comp = Workspace::local().get<T>(Workspace::ws_reduce, col);
+			std::fill_n(comp, col, T(0));
+			if (!accumulate)
+			{
+				std::fill_n(po, col, T(0));
+			}
+			detail::kahan_col_sum(m, 0, row, po, comp);
+			for (int j = 0; j < col; j++)
+			{
+				po[j] -= comp[j];
+			}
+			return;
+		}
+		//п飬ÿԵк벹partialcompŲϲ
+		//partialcompͬһ鹤
+		T* partial = Workspace::local().get<T>(Workspace::ws_reduce, (std::size_t)parts * col * 2);
+		T* comp = partial + (std::size_t)parts * col;
+		std::fill_n(partial, (std::size_t)parts * col * 2, T(0));
+		int chunk = (row + parts - 1) / parts;
+		parallel_run(parts, [&](int id) {
+			int r0 = id * chunk;
+			int r1 = std::min(row, r0 + chunk);
+			if (r0 < r1)
+			{
+				detail::kahan_col_sum(m, r0, r1, partial + (std::size_t)id * col, comp + (std::size_t)id * col);
+			}
+		});
+		for (int step = 1; step < parts; step *= 2)
+		{
+			for (int i = 0; i + step < parts; i += 2 * step)
+			{
+				std::size_t a = (std::size_t)i * col;
+				std::size_t b = (std::size_t)(i + step) * col;
+				detail::kahan_merge(partial + a, comp + a, partial + b, comp + b, col);
+			}
+		}
+		for (int j = 0; j < col; j++)
+		{
+			T v = partial[j] - comp[j];
+			po[j] = accumulate ? po[j] + v : v;
+		}
+	}
+
+	template<typename T>
+	Matrix2x<T> col_sum(const Matrix2x<T>& m)
+	{
+		Matrix2x<T>ends;
+		col_sum(m, ends);
+		return ends;
+	}
+
+	//ÿеľֵout(1 x col)
+	template<typename T>
+	void col_mean(const Matrix2x<T>& m, Matrix2x<T>& out)
+	{
+		col_sum(m, out);
+		if (m.get_row() > 0)
+		{
+			out *= T(1) / T(m.get_row());
+		}
+	}
+
+	namespace detail
+	{
+		//mÿһpvf(p, v, col)ʱв
+		template<typename T, typename F>
+		void broadcast_rows(Matrix2x<T>& m, F f)
+		{
+			int col = m.get_col();
+			parallel_for(0, m.get_row(), std::max<long long>(1, (long long)(reduce_parallel / std::max(col, 1))), [&](long long lo, long long hi) {
+				for (long long i = lo; i < hi; i++)
+				{
+					f((int)i, m[(int)i], col);
+				}
+			});
+		}
+	}
+
+	//㲥ÿһмalpha * vvcolԪ(1 x colcol x 1)
+	template<typename T>
+	void add_row_vector(Matrix2x<T>& m, const Matrix2x<T>& v, T alpha = T(1))
+	{
+		if (v.size() != (std::size_t)m.get_col())
+		{
+			std::cout << "㲥ʧЧĳһ" << std::endl;
+			return;
+		}
+		const T* pv = v.get_data();
+		detail::broadcast_rows(m, [=](int, T* p, int col) {
+			for (int j = 0; j < col; j++)
+			{
+				p[j] += alpha * pv[j];
+			}
+		});
+	}
+
+	//㲥iеÿԪؼalpha * v[i]vrowԪ
+	template<typename T>
+	void add_col_vector(Matrix2x<T>& m, const Matrix2x<T>& v, T alpha = T(1))
+	{
+		if (v.size() != (std::size_t)m.get_row())
+		{
+			std::cout << "㲥ʧЧĳһ" << std::endl;
+			return;
+		}
+		const T* pv = v.get_data();
+		detail::broadcast_rows(m, [=](int i, T* p, int col) {
+			T a = alpha * pv[i];
+			for (int j = 0; j < col; j++)
+			{
+				p[j] += a;
+			}
+		});
+	}
+
+	//㲥ÿһԪسv
+	template<typename T>
+	void mul_row_vector(Matrix2x<T>& m, const Matrix2x<T>& v)
+	{
+		if (v.size() != (std::size_t)m.get_col())
+		{
+			std::cout << "㲥ʧЧĳһ" << std::endl;
+			return;
+		}
+		const T* pv = v.get_data();
+		detail::broadcast_rows(m, [=](int, T* p, int col) {
+			for (int j = 0; j < col; j++)
+			{
+				p[j] *= pv[j];
+			}
+		});
+	}
+
+	//㲥iv[i]
+	template<typename T>
+	void mul_col_vector(Matrix2x<T>& m, const Matrix2x<T>& v)
+	{
+		if (v.size() != (std::size_t)m.get_row())
+		{
+			std::cout << "㲥ʧЧĳһ" << std::endl;
+			return;
+		}
+		const T* pv = v.get_data();
+		detail::broadcast_rows(m, [=](int i, T* p, int col) {
+			T a = pv[i];
+			for (int j = 0; j < col; j++)
+			{
+				p[j] *= a;
+			}
+		});
+	}
+}
+
+#endif // !_EIGEN1_REDUCE_H_
@@ -0,0 +1,531 @@
+#pragma once
+#ifndef _EIGEN1_SOLVER_H_
+#define _EIGEN1_SOLVER_H_
+
+#include <vector>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "eigen1.h"
+#include "eigen1_memory.h"
+#include "eigen1_parallel.h"
+
+//ֽʽ棺
+//CholeskyԳ A = L * L^T淽̡عȣһҲߡ
+//HouseholderQRA = Q * RС⣬ҪA^T * Aᱻƽ
+//߶зֿ(block_sizeһ)ֿķֽ⣬Ĵ󲿷ǰʵľ˼ӣ
+//ҶжУsolve()һνС
+
+namespace Eigen1
+{
+	//ֿС
+	const int solver_block_size = 64;
+
+	namespace detail
+	{
+		//mе(rr+1Ԫ)ֳpartsΣصidεʼ(к)
+		//ǰrеԼΪr^2/2Եidδ m * sqrt(id / parts) ʼÿεĹͬ
+		inline long long triangle_split(long long m, int id, int parts)
+		{
+			if (id >= parts)
+			{
+				return m;
+			}
+			return (long long)((double)m * std::sqrt((double)id / parts));
+		}
+	}
+
+	template<typename T>
+	class Cholesky
+	{
+	private:
+		Matrix2x<T> L;//ǴLǲʹ
+		bool ok = false;
+
+		//Խǿ[k, k+kb)Ĳֽֿ
+		bool factor_diag(int k, int kb)
+		{
+			for (int j = k; j < k + kb; j++)
+			{
+				T* lj = L[j];
+				T d = lj[j];
+				for (int p = k; p < j; p++)
+				{
+					d -= lj[p] * lj[p];
+				}
+				if (!(d > T(0)))
+				{
+					return false;
+				}
+				d = std::sqrt(d);
+				lj[j] = d;
+				for (int i = j + 1; i < k + kb; i++)
+				{
+					T* li = L[i];
+					T s = li[j];
+					for (int p = k; p < j; p++)
+					{
+						s -= li[p] * lj[p];
+					}
+					li[j] = s / d;
+				}
+			}
+			return true;
+		}
+
+	public:
+		//Ĭϳʼ
+		Cholesky() {};
+
+		//ֱӷֽa
+		explicit Cholesky(const Matrix2x<T>& a)
+		{
+			compute(a);
+		}
+
+		//ֽԳaֻȡaǣɹtrue
+		bool compute(const Matrix2x<T>& a)
+		{
+			ok = false;
+			if (a.get_row() != a.get_col())
+			{
+				std::cout << "Ϊ޷Choleskyֽ" << std::endl;
+				return false;
+			}
+			L = a;
+			int n = a.get_row();
+			const int nb = solver_block_size;
+			for (int k = 0; k < n; k += nb)
+			{
+				int kb = std::min(nb, n - k);
+				//1.Խǿ
+				if (!factor_diag(k, kb))
+				{
+					std::cout << "ǶԳ޷Choleskyֽ" << std::endl;
+					return false;
+				}
+				//2.Խǿ·壺L21 = A21 * L11^-Tÿжǰ
+				parallel_for(k + kb, n, 32, [&](long long lo, long long hi) {
+					for (long long i = lo; i < hi; i++)
+					{
+						T* li = L[(int)i];
+						for (int j = k; j < k + kb; j++)
+						{
+							const T* lj = L[j];
+							T s = li[j];
+							for (int p = k; p < j; p++)
+							{
+								s -= li[p] * lj[p];
+							}
+							li[j] = s / lj[j];
+						}
+					}
+				});
+				//3.β£A22 -= L21 * L21^Tֻǣ֮ǳkb
+				//ԽµҪĵԽ࣬ƽлһ̸߳ɴ󲿷ֻ԰
+				int s0 = k + kb;
+				auto update = [&](long long lo, long long hi) {
+					for (long long i = lo; i < hi; i++)
+					{
+						T* li = L[(int)i];
+						for (long long j = s0; j <= i; j++)
+						{
+							const T* lj = L[(int)j];
+							T s = 0;
+							for (int p = k; p < k + kb; p++)
+							{
+								s += li[p] * lj[p];
+							}
+							li[j] -= s;
+						}
+					}
+				};
+				long long m = n - s0;
+				int parts = (int)std::min<long long>(get_num_threads(), m / 16);
+				if (parts <= 1)
+				{
+					update(s0, n);
+				}
+				else
+				{
+					parallel_run(parts, [&](int id) {
+						update(s0 + detail::triangle_split(m, id, parts), s0 + detail::triangle_split(m, id + 1, parts));
+					});
+				}
+			}
+			//㣬get_L()ֱӷǾ
+			for (int i = 0; i < n; i++)
+			{
+				std::fill(L[i] + i + 1, L[i] + n, T(0));
+			}
+			ok = true;
+			return true;
+		}
+
+		//ֽǷɹ
+		bool is_ok() const
+		{
+			return ok;
+		}
+
+		//L
+		const Matrix2x<T>& get_L() const
+		{
+			return L;
+		}
+
+		//A * X = BBжУԭذ汾ֱӰBдX
+		void solve_in_place(Matrix2x<T>& b) const
+		{
+			int n = L.get_row();
+			if (!ok || b.get_row() != n)
+			{
+				std::cout << "CholeskyʧЧֽǷɹԼҶ" << std::endl;
+				return;
+			}
+			int m = b.get_col();
+			//ǰ L * Y = Biмȥǰе
+			for (int i = 0; i < n; i++)
+			{
+				const T* li = L[i];
+				T* bi = b[i];
+				for (int j = 0; j < i; j++)
+				{
+					T lij = li[j];
+					const T* bj = b[j];
+					for (int c = 0; c < m; c++)
+					{
+						bi[c] -= lij * bj[c];
+					}
+				}
+				T r = T(1) / li[i];
+				for (int c = 0; c < m; c++)
+				{
+					bi[c] *= r;
+				}
+			}
+			//ش L^T * X = YiкǰֻзL
+			for (int i = n - 1; i >= 0; i--)
+			{
+				const T* li = L[i];
+				T* bi = b[i];
+				T r = T(1) / li[i];
+				for (int c = 0; c < m; c++)
+				{
+					bi[c] *= r;
+				}
+				for (int j = 0; j < i; j++)
+				{
+					T lij = li[j];
+					T* bj = b[j];
+					for (int c = 0; c < m; c++)
+					{
+						bj[c] -= lij * bi[c];
+					}
+				}
+			}
+		}
+
+		//A * X = BX
+		Matrix2x<T> solve(const Matrix2x<T>& b) const
+		{
+			Matrix2x<T>ends(b);
+			solve_in_place(ends);
+			return ends;
+		}
+
+		//ʽLԽ߳˻ƽ
+		T det() const
+		{
+			T d = 1;
+			for (int i = 0; i < L.get_row(); i++)
+			{
+				d *= L[i][i];
+			}
+			return d * d;
+		}
+	};
+
+	template<typename T>
+	class HouseholderQR
+	{
+	private:
+		Matrix2x<T> QR;//ǴRԽ´Householderv(vԪ1)
+		std::vector<T> tau;//ÿϵH = I - tau * v * v^T
+		std::vector<Matrix2x<T>> block_T;//ÿĽWYʾTķ˻ = I - V * T * V^T
+		bool ok = false;
+
+		double zero_rate = 0.000001;//̫СΪ0
+
+		//ѵkĿ鷴(ת)õc[k, m)С[c0, c1)Уc -= V * T^T * (V^T * c)
+		//ǰʣзи߳
+		void apply_block_transpose(int k, int kb, Matrix2x<T>& c, int c0, int c1) const
+		{
+			int m = QR.get_row();
+			const Matrix2x<T>& t = block_T[k / solver_block_size];
+			parallel_for(c0, c1, 64, [&](long long lo, long long hi) {
+				int w = (int)(hi - lo);
+				aligned_vector<T> work((std::size_t)kb * w, T(0));
+				//W = V^T * C
+				for (int r = k; r < m; r++)
+				{
+					const T* vr = QR[r];
+					const T* cr = c[r] + lo;
+					for (int j = 0; j < kb && k + j <= r; j++)
+					{
+						T v = (k + j == r) ? T(1) : vr[k + j];
+						T* wj = work.data() + (std::size_t)j * w;
+						for (int q = 0; q < w; q++)
+						{
+							wj[q] += v * cr[q];
+						}
+					}
+				}
+				//W = T^T * WTǣԭؼ
+				for (int j = kb - 1; j >= 0; j--)
+				{
+					T* wj = work.data() + (std::size_t)j * w;
+					T tjj = t[j][j];
+					for (int q = 0; q < w; q++)
+					{
+						wj[q] *= tjj;
+					}
+					for (int p = 0; p < j; p++)
+					{
+						T tpj = t[p][j];
+						const T* wp = work.data() + (std::size_t)p * w;
+						for (int q = 0; q < w; q++)
+						{
+							wj[q] += tpj * wp[q];
+						}
+					}
+				}
+				//C -= V * W
+				for (int r = k; r < m; r++)
+				{
+					const T* vr = QR[r];
+					T* cr = c[r] + lo;
+					for (int j = 0; j < kb && k + j <= r; j++)
+					{
+						T v = (k + j == r) ? T(1) : vr[k + j];
+						const T* wj = work.data() + (std::size_t)j * w;
+						for (int q = 0; q < w; q++)
+						{
+							cr[q] -= v * wj[q];
+						}
+					}
+				}
+			});
+		}
+
+	public:
+		//Ĭϳʼ
+		HouseholderQR() {};
+
+		//ֱӷֽa
+		explicit HouseholderQR(const Matrix2x<T>& a)
+		{
+			compute(a);
+		}
+
+		//ֽa()ɹtrue
+		bool compute(const Matrix2x<T>& a)
+		{
+			ok = false;
+			int m = a.get_row();
+			int n = a.get_col();
+			if (m < n)
+			{
+				std::cout << "޷QRС˷ֽ" << std::endl;
+				return false;
+			}
+			QR = a;
+			tau.assign(n, T(0));
+			block_T.clear();
+			const int nb = solver_block_size;
+			std::vector<T> w;
+			for (int k = 0; k < n; k += nb)
+			{
+				int kb = std::min(nb, n - k);
+				//1.ڲֿHouseholderֽ⣬ֻڵ
+				for (int j = k; j < k + kb; j++)
+				{
+					T norm2 = 0;
+					for (int r = j + 1; r < m; r++)
+					{
+						norm2 += QR[r][j] * QR[r][j];
+					}
+					T alpha = QR[j][j];
+					if (norm2 == T(0))
+					{
+						tau[j] = 0;
+						continue;
+					}
+					T beta = std::sqrt(alpha * alpha + norm2);
+					if (alpha > 0)
+					{
+						beta = -beta;
+					}
+					tau[j] = (beta - alpha) / beta;
+					T scale = T(1) / (alpha - beta);
+					for (int r = j + 1; r < m; r++)
+					{
+						QR[r][j] *= scale;
+					}
+					QR[j][j] = beta;
+
+					//Hõʣµ
+					int pw = k + kb - j - 1;
+					if (pw == 0)
+					{
+						continue;
+					}
+					w.assign(pw, T(0));
+					for (int r = j; r < m; r++)
+					{
+						T v = r == j ? T(1) : QR[r][j];
+						const T* qr = QR[r] + j + 1;
+						for (int q = 0; q < pw; q++)
+						{
+							w[q] += v * qr[q];
+						}
+					}
+					for (int r = j; r < m; r++)
+					{
+						T v = (r == j ? T(1) : QR[r][j]) * tau[j];
+						T* qr = QR[r] + j + 1;
+						for (int q = 0; q < pw; q++)
+						{
+							qr[q] -= v * w[q];
+						}
+					}
+				}
+
+				//2.WYʾTT[0:j, j] = -tau_j * T[0:j, 0:j] * (V[:, 0:j]^T * v_j)
+				Matrix2x<T> t(kb, kb);
+				std::vector<T> dot(kb);
+				for (int j = 0; j < kb; j++)
+				{
+					int cj = k + j;
+					std::fill(dot.begin(), dot.end(), T(0));
+					for (int r = cj; r < m; r++)
+					{
+						T vj = r == cj ? T(1) : QR[r][cj];
+						const T* qr = QR[r];
+						for (int p = 0; p < j; p++)
+						{
+							T vp = (k + p == r) ? T(1) : qr[k + p];
+							dot[p] += vp * vj;
+						}
+					}
+					for (int p = 0; p < j; p++)
+					{
+						T s = 0;
+						for (int q = p; q < j; q++)
+						{
+							s += t[p][q] * dot[q];
+						}
+						t[p][j] = -tau[cj] * s;
+					}
+					t[j][j] = tau[cj];
+				}
+				block_T.push_back(std::move(t));
+
+				//3.鷴õұߵβ
+				if (k + kb < n)
+				{
+					apply_block_transpose(k, kb, QR, k + kb, n);
+				}
+			}
+			for (int i = 0; i < n; i++)
+			{
+				if (std::abs(QR[i][i]) < zero_rate)
+				{
+					std::cout << "ȿ޷QRС" << std::endl;
+					return false;
+				}
+			}
+			ok = true;
+			return true;
+		}
+
+		//ֽǷɹ
+		bool is_ok() const
+		{
+			return ok;
+		}
+
+		//n x nR
+		Matrix2x<T> get_R() const
+		{
+			int n = QR.get_col();
+			Matrix2x<T>ends(n, n);
+			for (int i = 0; i < n; i++)
+			{
+				for (int j = i; j < n; j++)
+				{
+					ends[i][j] = QR[i][j];
+				}
+			}
+			return ends;
+		}
+
+		//Q^Tԭõb(bA)
+		void apply_QT(Matrix2x<T>& b) const
+		{
+			if (b.get_row() != QR.get_row())
+			{
+				std::cout << "QRʧЧҶǷһ" << std::endl;
+				return;
+			}
+			int n = QR.get_col();
+			for (int k = 0; k < n; k += solver_block_size)
+			{
+				apply_block_transpose(k, std::min(solver_block_size, n - k), b, 0, b.get_col());
+			}
+		}
+
+		//С˽⣺min ||A * X - B||BжУn x B.colX
+		Matrix2x<T> solve(const Matrix2x<T>& b) const
+		{
+			int n = QR.get_col();
+			if (!ok || b.get_row() != QR.get_row())
+			{
+				std::cout << "QRʧЧֽǷɹԼҶ" << std::endl;
+				return Matrix2x<T>(n, b.get_col());
+			}
+			Matrix2x<T>qtb(b);
+			apply_QT(qtb);
+			int m = b.get_col();
+			Matrix2x<T>ends(n, m);
+			for (int i = 0; i < n; i++)
+			{
+				std::copy_n(qtb[i], m, ends[i]);
+			}
+			//ش R * X = (Q^T * B)ǰn
+			for (int i = n - 1; i >= 0; i--)
+			{
+				const T* ri = QR[i];
+				T* xi = ends[i];
+				for (int j = i + 1; j < n; j++)
+				{
+					T rij = ri[j];
+					const T* xj = ends[j];
+					for (int c = 0; c < m; c++)
+					{
+						xi[c] -= rij * xj[c];
+					}
+				}
+				T r = T(1) / ri[i];
+				for (int c = 0; c < m; c++)
+				{
+					xi[c] *= r;
+				}
+			}
+			return ends;
+		}
+	};
+}
+
+#endif // !_EIGEN1_SOLVER_H_
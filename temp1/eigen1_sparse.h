@@ -0,0 +1,344 @@
+#pragma once
+#ifndef _EIGEN1_SPARSE_H_
+#define _EIGEN1_SPARSE_H_
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include "eigen1.h"
+#include "eigen1_parallel.h"
+
+//ϡ󣬰CSR(ѹ)ʽ洢
+//row_ptr[i]row_ptr[i+1]֮ǵiеķԪкcol_idxֵvalues
+//ͬһ鰴"";תþCSCʽtranspose()õCSRҲԭCSC
+//ڴֻͷԪnnzȡ
+
+namespace Eigen1
+{
+	//COOʽһԪ(, , ֵ)װϡ
+	template<typename T>
+	struct Triplet
+	{
+		int row;
+		int col;
+		T value;
+
+		Triplet(int r, int c, T v) :row(r), col(c), value(v) {};
+	};
+
+	template<typename T>
+	class SparseMatrix
+	{
+	private:
+		int row;//
+		int col;//
+		std::vector<int> row_ptr;//row+1
+		std::vector<int> col_idx;//nnz
+		std::vector<T> values;//nnz
+
+		//ÿ߳ٷֵôԪֵÿ߳
+		static const int parallel_nnz = 1 << 15;
+
+		//ԪогnΣصidεʼ
+		int split_row(int id, int n) const
+		{
+			long long target = (long long)nnz() * id / n;
+			return (int)(std::lower_bound(row_ptr.begin(), row_ptr.end(), target) - row_ptr.begin());
+		}
+
+		//ÿһвִf(, յ)
+		template<typename F>
+		void for_each_rows(F f) const
+		{
+			int n = std::min(get_num_threads(), nnz() / parallel_nnz + 1);
+			if (n <= 1)
+			{
+				f(0, this->row);
+				return;
+			}
+			parallel_run(n, [&](int id) {
+				int lo = std::min(split_row(id, n), this->row);
+				int hi = id == n - 1 ? this->row : std::min(split_row(id + 1, n), this->row);
+				f(lo, hi);
+			});
+		}
+
+	public:
+		//Ĭϳʼ
+		SparseMatrix() :row(0), col(0), row_ptr(1, 0) {};
+
+		//гʼȫΪ
+		SparseMatrix(int size_row, int size_col) :row(size_row), col(size_col), row_ptr(size_row + 1, 0) {};
+
+		//COOԪװCSRظ(, )ۼ
+		SparseMatrix(int size_row, int size_col, const std::vector<Triplet<T>>& triplets) :row(size_row), col(size_col)
+		{
+			set_from_triplets(triplets);
+		}
+
+		//COOԪװȰм(O(nnz))ٶÿа򲢺ϲظ
+		void set_from_triplets(const std::vector<Triplet<T>>& triplets)
+		{
+			row_ptr.assign(this->row + 1, 0);
+			for (const Triplet<T>& t : triplets)
+			{
+				if (t.row < 0 || t.row >= this->row || t.col < 0 || t.col >= this->col)
+				{
+					std::cout << "ϡ±곬ѺԸԪ" << std::endl;
+					continue;
+				}
+				row_ptr[t.row + 1]++;
+			}
+			for (int i = 0; i < this->row; i++)
+			{
+				row_ptr[i + 1] += row_ptr[i];
+			}
+
+			std::vector<int> pos(row_ptr.begin(), row_ptr.end() - 1);
+			std::vector<std::pair<int, T>> entries(row_ptr[this->row]);
+			for (const Triplet<T>& t : triplets)
+			{
+				if (t.row < 0 || t.row >= this->row || t.col < 0 || t.col >= this->col)
+				{
+					continue;
+				}
+				entries[pos[t.row]++] = std::make_pair(t.col, t.value);
+			}
+
+			col_idx.clear();
+			values.clear();
+			col_idx.reserve(entries.size());
+			values.reserve(entries.size());
+			int begin = 0;
+			for (int i = 0; i < this->row; i++)
+			{
+				int end = row_ptr[i + 1];
+				std::sort(entries.begin() + begin, entries.begin() + end,
+					[](const std::pair<int, T>& a, const std::pair<int, T>& b) { return a.first < b.first; });
+				int start = (int)col_idx.size();
+				for (int k = begin; k < end; k++)
+				{
+					if ((int)col_idx.size() > start && col_idx.back() == entries[k].first)
+					{
+						values.back() += entries[k].second;
+					}
+					else
+					{
+						col_idx.push_back(entries[k].first);
+						values.push_back(entries[k].second);
+					}
+				}
+				row_ptr[i + 1] = (int)col_idx.size();
+				begin = end;
+			}
+		}
+
+		//ӳܾ죬ֵzero_rateԪΪ0
+		static SparseMatrix from_dense(const Matrix2x<T>& a, double zero_rate = 0.0)
+		{
+			SparseMatrix ends(a.get_row(), a.get_col());
+			for (int i = 0; i < ends.row; i++)
+			{
+				for (int j = 0; j < ends.col; j++)
+				{
+					T v = a[i][j];
+					if (std::abs(v) > zero_rate)
+					{
+						ends.col_idx.push_back(j);
+						ends.values.push_back(v);
+					}
+				}
+				ends.row_ptr[i + 1] = (int)ends.col_idx.size();
+			}
+			return ends;
+		}
+
+		//תɳܾ
+		Matrix2x<T> to_dense() const
+		{
+			Matrix2x<T>ends(this->row, this->col);
+			for (int i = 0; i < this->row; i++)
+			{
+				for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+				{
+					ends[i][col_idx[k]] = values[k];
+				}
+			}
+			return ends;
+		}
+
+		//
+		int get_row() const
+		{
+			return this->row;
+		}
+
+		//
+		int get_col() const
+		{
+			return this->col;
+		}
+
+		//Ԫ
+		int nnz() const
+		{
+			return row_ptr[this->row];
+		}
+
+		//ֱӷCSR
+		const std::vector<int>& get_row_ptr() const
+		{
+			return row_ptr;
+		}
+		const std::vector<int>& get_col_idx() const
+		{
+			return col_idx;
+		}
+		const std::vector<T>& get_values() const
+		{
+			return values;
+		}
+
+		//ȡ(i, j)ֵڵiֲ
+		T coeff(int i, int j) const
+		{
+			if (i < 0 || i >= this->row || j < 0 || j >= this->col)
+			{
+				std::cout << "±곬" << std::endl;
+				return T(0);
+			}
+			auto first = col_idx.begin() + row_ptr[i];
+			auto last = col_idx.begin() + row_ptr[i + 1];
+			auto it = std::lower_bound(first, last, j);
+			if (it != last && *it == j)
+			{
+				return values[it - col_idx.begin()];
+			}
+			return T(0);
+		}
+
+		//תãCSRԭCSC
+		SparseMatrix transpose() const
+		{
+			SparseMatrix ends(this->col, this->row);
+			ends.col_idx.resize(nnz());
+			ends.values.resize(nnz());
+			for (int k = 0; k < nnz(); k++)
+			{
+				ends.row_ptr[col_idx[k] + 1]++;
+			}
+			for (int j = 0; j < this->col; j++)
+			{
+				ends.row_ptr[j + 1] += ends.row_ptr[j];
+			}
+			std::vector<int> pos(ends.row_ptr.begin(), ends.row_ptr.end() - 1);
+			for (int i = 0; i < this->row; i++)
+			{
+				for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+				{
+					int p = pos[col_idx[k]]++;
+					ends.col_idx[p] = i;
+					ends.values[p] = values[k];
+				}
+			}
+			return ends;
+		}
+
+		//ϡy = alpha * A * x + beta * yxΪcolyΪrow
+		//Ԫоָ̣߳ÿֻ߳дԼһy
+		void spmv(const T* x, T* y, T alpha = T(1), T beta = T(0)) const
+		{
+			const int* rp = row_ptr.data();
+			const int* ci = col_idx.data();
+			const T* v = values.data();
+			for_each_rows([&](int lo, int hi) {
+				for (int i = lo; i < hi; i++)
+				{
+					T temp = 0;
+					for (int k = rp[i]; k < rp[i + 1]; k++)
+					{
+						temp += v[k] * x[ci[k]];
+					}
+					y[i] = beta == T(0) ? alpha * temp : alpha * temp + beta * y[i];
+				}
+			});
+		}
+
+		//*ϡ*
+		friend std::vector<T> operator *(const SparseMatrix<T>& a, const std::vector<T>& x)
+		{
+			if ((int)x.size() != a.col)
+			{
+				std::cout << "˷ʧЧĳǷͬ" << std::endl;
+				return std::vector<T>();
+			}
+			std::vector<T> y(a.row, 0);
+			a.spmv(x.data(), y.data());
+			return y;
+		}
+
+		//ϡ*ܣc = alpha * A * b + beta * ccѾ(A.row x b.col)
+		//iеĽAiиԪbӦеϣbcǰ
+		friend void spmm(T alpha, const SparseMatrix<T>& a, const Matrix2x<T>& b, T beta, Matrix2x<T>& c)
+		{
+			if (b.get_row() != a.col || c.get_row() != a.row || c.get_col() != b.get_col())
+			{
+				std::cout << "˷ʧЧǰǷͬ" << std::endl;
+				return;
+			}
+			int n = b.get_col();
+			if (n == 0)
+			{
+				return;
+			}
+			a.for_each_rows([&](int lo, int hi) {
+				for (int i = lo; i < hi; i++)
+				{
+					T* pc = &c[i][0];
+					for (int j = 0; j < n; j++)
+					{
+						pc[j] = beta == T(0) ? T(0) : pc[j] * beta;
+					}
+					for (int k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+					{
+						T temp = alpha * a.values[k];
+						const T* pb = &b[a.col_idx[k]][0];
+						for (int j = 0; j < n; j++)
+						{
+							pc[j] += temp * pb[j];
+						}
+					}
+				}
+			});
+		}
+
+		//*ϡ*ܾ
+		friend Matrix2x<T> operator *(const SparseMatrix<T>& a, const Matrix2x<T>& b)
+		{
+			if (b.get_row() != a.col)
+			{
+				std::cout << "˷ʧЧǰǷͬ" << std::endl;
+				return b;
+			}
+			Matrix2x<T>ends(a.row, b.get_col());
+			spmm(T(1), a, b, T(0), ends);
+			return ends;
+		}
+
+		//ϡչʾֻӡԪ
+		void show() const
+		{
+			for (int i = 0; i < this->row; i++)
+			{
+				for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+				{
+					std::cout << "(" << i << ", " << col_idx[k] << ") " << values[k] << std::endl;
+				}
+			}
+		}
+	};
+}
+
+#endif // !_EIGEN1_SPARSE_H_
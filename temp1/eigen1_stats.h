@@ -0,0 +1,346 @@
+#pragma once
+#ifndef _EIGEN1_STATS_H_
+#define _EIGEN1_STATS_H_
+
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef EIGEN1_STATS
+#include <atomic>
+#endif
+
+//ڴͿļصʱ
+//ĬϹرգûжEIGEN1_STATSʱEIGEN1_STATչΪգûκοStatsScopeȫ0
+//ĿﶨEIGEN1_STATS(ڰͷļ֮ǰ#define)ȫֵԭӱ̵߳Ķڡ
+//ÿ(EIGEN1_STATֵλ)һ˰ĺϼƣܰ䡢�
+//ļֻԼ֪ķ䣻Ҫstd::vectorݡstd::functionmake_sharedྭoperator newĶѷ䣬
+//ǡһ.cpp#define EIGEN1_STATS_COUNT_HEAPٰͷļȫoperator newᱻ滻ɼİ汾(ֻ)
+//÷
+//	Eigen1::StatsScope scope;
+//	...ѵһ...
+//	Eigen1::StatCounters c = scope.report();
+//	c.print();  //߼ c.allocations() == 0
+
+namespace Eigen1
+{
+	//
+	enum stat_kind
+	{
+		stat_matrix_alloc = 0,//Matrix2xڴ(ڴõ)
+		stat_matrix_copy,//Matrix2x(졢״ͬͬĿֵ)
+		stat_matrix_temp,//inv()ɵ¾
+		stat_pool_miss,//ڴûл棬ֻϵͳҪĴ
+		stat_workspace_grow,//WorkspaceĻ
+		stat_var_node,//AD::Varautodiff::Var½ļͼڵ
+		stat_heap,//ȫoperator newĶѷ䣬ֻжEIGEN1_STATS_COUNT_HEAPż
+		stat_kind_count
+	};
+
+	//ֿͳƵļֻϼ
+	const int stat_max_sites = 64;
+
+	inline const char* stat_name(int kind)
+	{
+		static const char* names[stat_kind_count] = { "matrix_alloc", "matrix_copy", "matrix_temp", "pool_miss", "workspace_grow", "var_node", "heap" };
+		return kind >= 0 && kind < stat_kind_count ? names[kind] : "unknown";
+	}
+
+	//ĴֽԼÿĴֽ
+	struct StatCounters
+	{
+		unsigned long long count[stat_kind_count];
+		unsigned long long bytes[stat_kind_count];
+		int sites;//Ǽǹļ
+		int site_kind[stat_max_sites];
+		const char* site_op[stat_max_sites];
+		unsigned long long site_count[stat_max_sites];
+		unsigned long long site_bytes[stat_max_sites];
+		bool heap_counted;//operator newǷ滻˼İ汾
+
+		StatCounters() :sites(0), heap_counted(false)
+		{
+			for (int k = 0; k < stat_kind_count; k++)
+			{
+				count[k] = 0;
+				bytes[k] = 0;
+			}
+		}
+
+		//ο֮ֻӣbеһҲУ±ͬ
+		StatCounters operator -(const StatCounters& b) const
+		{
+			StatCounters ends = *this;
+			for (int k = 0; k < stat_kind_count; k++)
+			{
+				ends.count[k] = count[k] - b.count[k];
+				ends.bytes[k] = bytes[k] - b.bytes[k];
+			}
+			for (int i = 0; i < b.sites; i++)
+			{
+				ends.site_count[i] = site_count[i] - b.site_count[i];
+				ends.site_bytes[i] = site_bytes[i] - b.site_bytes[i];
+			}
+			return ends;
+		}
+
+		//Ϊopм(ͬһڲͬ͵ģһ)Ĵ֮
+		unsigned long long count_of(const char* op) const
+		{
+			unsigned long long n = 0;
+			for (int i = 0; i < sites; i++)
+			{
+				if (std::strcmp(site_op[i], op) == 0)
+				{
+					n += site_count[i];
+				}
+			}
+			return n;
+		}
+
+		//ڴĴݡ϶ѷ䡣
+		//ͼڵmake_sharedģ滻operator newʱѾheapظ
+		unsigned long long allocations() const
+		{
+			return count[stat_matrix_alloc] + count[stat_workspace_grow] + (heap_counted ? count[stat_heap] : count[stat_var_node]);
+		}
+
+		//ȴӡϼƣٴӡмļ
+		void print() const
+		{
+			for (int k = 0; k < stat_kind_count; k++)
+			{
+				std::cout << stat_name(k) << "\t" << count[k] << "\t" << bytes[k] << " bytes" << std::endl;
+			}
+			for (int i = 0; i < sites; i++)
+			{
+				if (site_count[i] != 0)
+				{
+					std::cout << "  " << stat_name(site_kind[i]) << "\t" << site_op[i] << "\t" << site_count[i] << "\t" << site_bytes[i] << " bytes" << std::endl;
+				}
+			}
+		}
+	};
+
+	namespace detail
+	{
+#ifdef EIGEN1_STATS
+		struct StatStorage
+		{
+			std::atomic<unsigned long long> count[stat_kind_count];
+			std::atomic<unsigned long long> bytes[stat_kind_count];
+
+			StatStorage()
+			{
+				for (int k = 0; k < stat_kind_count; k++)
+				{
+					count[k].store(0);
+					bytes[k].store(0);
+				}
+			}
+		};
+
+		inline StatStorage& stat_storage()
+		{
+			static StatStorage s;
+			return s;
+		}
+
+		struct StatSite;
+
+		//Ǽǹļ㣬ֻ
+		struct StatRegistry
+		{
+			std::atomic<int> n;
+			std::atomic<StatSite*> sites[stat_max_sites];
+		};
+
+		//̬洢㣬ﲻҪ캯operator newһõҲǰȫ
+		inline StatRegistry& stat_registry()
+		{
+			static StatRegistry r;
+			return r;
+		}
+
+		//һ㣬EIGEN1_STATԼλ÷һ̬󣬵һִʱǼ
+		struct StatSite
+		{
+			int kind;
+			const char* op;
+			std::atomic<unsigned long long> count;
+			std::atomic<unsigned long long> bytes;
+
+			StatSite(int k, const char* name) :kind(k), op(name), count(0), bytes(0)
+			{
+				StatRegistry& r = stat_registry();
+				int id = r.n.fetch_add(1);
+				if (id < stat_max_sites)
+				{
+					r.sites[id].store(this, std::memory_order_release);
+				}
+			}
+
+			void add(std::size_t b)
+			{
+				count.fetch_add(1, std::memory_order_relaxed);
+				bytes.fetch_add(b, std::memory_order_relaxed);
+				StatStorage& s = stat_storage();
+				s.count[kind].fetch_add(1, std::memory_order_relaxed);
+				s.bytes[kind].fetch_add(b, std::memory_order_relaxed);
+			}
+		};
+
+		//operator newǷ滻˼İ汾
+		inline bool& stat_heap_hooked()
+		{
+			static bool hooked = false;
+			return hooked;
+		}
+#endif
+	}
+
+	//Ƿ˼
+	inline constexpr bool stats_enabled()
+	{
+#ifdef EIGEN1_STATS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	//ǰۼֵ
+	inline StatCounters stats_snapshot()
+	{
+		StatCounters ends;
+#ifdef EIGEN1_STATS
+		detail::StatStorage& s = detail::stat_storage();
+		for (int k = 0; k < stat_kind_count; k++)
+		{
+			ends.count[k] = s.count[k].load(std::memory_order_relaxed);
+			ends.bytes[k] = s.bytes[k].load(std::memory_order_relaxed);
+		}
+		detail::StatRegistry& r = detail::stat_registry();
+		int n = std::min(r.n.load(std::memory_order_acquire), stat_max_sites);
+		for (int i = 0; i < n; i++)
+		{
+			//Ǽǵһ(±ˣָ뻹ûд)ļȲ㣬ļ0
+			detail::StatSite* site = r.sites[i].load(std::memory_order_acquire);
+			ends.site_kind[i] = site ? site->kind : stat_kind_count;
+			ends.site_op[i] = site ? site->op : "";
+			ends.site_count[i] = site ? site->count.load(std::memory_order_relaxed) : 0;
+			ends.site_bytes[i] = site ? site->bytes.load(std::memory_order_relaxed) : 0;
+		}
+		ends.sites = n;
+		ends.heap_counted = detail::stat_heap_hooked();
+#endif
+		return ends;
+	}
+
+	//report()شӹ(һrestart)ڵ
+	class StatsScope
+	{
+	private:
+		StatCounters start;
+
+	public:
+		StatsScope() :start(stats_snapshot()) {};
+
+		StatCounters report() const
+		{
+			return stats_snapshot() - start;
+		}
+
+		void restart()
+		{
+			start = stats_snapshot();
+		}
+	};
+}
+
+//EIGEN1_STAT(, "", ֽ)ͬһλõļڱﵥг
+#ifdef EIGEN1_STATS
+#define EIGEN1_STAT(kind, op, bytes) do { static ::Eigen1::detail::StatSite eigen1_stat_site(::Eigen1::kind, op); eigen1_stat_site.add((std::size_t)(bytes)); } while (0)
+#else
+#define EIGEN1_STAT(kind, op, bytes) ((void)0)
+#endif
+
+//滻ȫoperator new/deleteǵÿһζѷ䡣ֻһ.cppEIGEN1_STATS_COUNT_HEAP
+#if defined(EIGEN1_STATS) && defined(EIGEN1_STATS_COUNT_HEAP)
+#include <cstdlib>
+#include <new>
+
+namespace Eigen1
+{
+	namespace detail
+	{
+		inline void* stat_heap_alloc(std::size_t n, const std::nothrow_t&) noexcept
+		{
+			EIGEN1_STAT(stat_heap, "operator new", n);
+			return std::malloc(n == 0 ? 1 : n);
+		}
+
+		inline void* stat_heap_alloc(std::size_t n)
+		{
+			void* p = stat_heap_alloc(n, std::nothrow);
+			if (p == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+			return p;
+		}
+
+		//ͷҲһñnewfreeԼ
+		inline void stat_heap_free(void* p) noexcept
+		{
+			std::free(p);
+		}
+
+		static const bool stat_heap_hook_installed = (stat_heap_hooked() = true);
+	}
+}
+
+void* operator new(std::size_t n)
+{
+	return ::Eigen1::detail::stat_heap_alloc(n);
+}
+void* operator new[](std::size_t n)
+{
+	return ::Eigen1::detail::stat_heap_alloc(n);
+}
+void* operator new(std::size_t n, const std::nothrow_t& t) noexcept
+{
+	return ::Eigen1::detail::stat_heap_alloc(n, t);
+}
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept
+{
+	return ::Eigen1::detail::stat_heap_alloc(n, t);
+}
+void operator delete(void* p) noexcept
+{
+	::Eigen1::detail::stat_heap_free(p);
+}
+void operator delete[](void* p) noexcept
+{
+	::Eigen1::detail::stat_heap_free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+	::Eigen1::detail::stat_heap_free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+	::Eigen1::detail::stat_heap_free(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	::Eigen1::detail::stat_heap_free(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	::Eigen1::detail::stat_heap_free(p);
+}
+#endif
+
+#endif // !_EIGEN1_STATS_H_
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef _GRAD_MODE_H_
+#define _GRAD_MODE_H_
+
+//󵼿أÿ̸߳һݡ
+//NoGradGuardAD::Varautodiff::Varֵֻͼڵ㡢ƫ
+//NNĲҲٱ淴򴫲Ҫõмֻ֤Ҫֵĳϡ
+
+namespace AD
+{
+	namespace detail
+	{
+		inline bool& grad_flag()
+		{
+			static thread_local bool flag = true;
+			return flag;
+		}
+	}
+
+	//ǰ߳Ƿ¼ͼ
+	inline bool grad_enabled()
+	{
+		return detail::grad_flag();
+	}
+
+	//ڹر󵼣ʱָԭ״̬Ƕ
+	class NoGradGuard
+	{
+	private:
+		bool prev;
+
+	public:
+		NoGradGuard() :prev(detail::grad_flag())
+		{
+			detail::grad_flag() = false;
+		}
+
+		~NoGradGuard()
+		{
+			detail::grad_flag() = prev;
+		}
+
+		NoGradGuard(const NoGradGuard&) = delete;
+		NoGradGuard& operator =(const NoGradGuard&) = delete;
+	};
+}
+
+#endif // !_GRAD_MODE_H_
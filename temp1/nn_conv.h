@@ -0,0 +1,584 @@
+#pragma once
+#ifndef _NN_CONV_H_
+#define _NN_CONV_H_
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+
+#include "eigen1.h"
+#include "eigen1_memory.h"
+#include "eigen1_parallel.h"
+#include "eigen1_reduce.h"
+#include "grad_mode.h"
+#include "nn_layer.h"
+
+//ͳػ㡣DenseһһռһУͼ(, , ͨ)չ(HWCͨڲ)
+//һάźžǸΪ1ͼػȫӲֱSequentialﴮ
+//im2colɾ˷
+//	cols((*λ) x (kh*kw*ͨ))ÿһλöӦ봰
+//	Y = cols * W + bW(kh*kw*ͨ x ˸)
+//HWCY״(*λ x ˸)ڴþ( x )š
+//dW += cols^T * dYdcols = dY * W^Tcol2imdcolsۼӻݶȡ
+//colsWorkspaceֿ飬ĴСconv_blockԪأѵʱٷ䡣
+
+namespace NN
+{
+	//ػļβ
+	struct ConvShape
+	{
+		int channels;//ͨ
+		int height;//ĸ
+		int width;//Ŀ
+		int kernel_h;
+		int kernel_w;
+		int stride_h;
+		int stride_w;
+		int pad_h;//¸0
+		int pad_w;//Ҹ0
+
+		ConvShape(int c, int h, int w, int kh, int kw, int sh = 1, int sw = 1, int ph = 0, int pw = 0)
+			:channels(c), height(h), width(w), kernel_h(kh), kernel_w(kw), stride_h(sh), stride_w(sw), pad_h(ph), pad_w(pw) {};
+
+		int out_h() const
+		{
+			return (height + 2 * pad_h - kernel_h) / stride_h + 1;
+		}
+
+		int out_w() const
+		{
+			return (width + 2 * pad_w - kernel_w) / stride_w + 1;
+		}
+
+		//λ
+		int positions() const
+		{
+			return out_h() * out_w();
+		}
+
+		//һڵԪظ
+		int patch() const
+		{
+			return kernel_h * kernel_w * channels;
+		}
+
+		//һ
+		int in_size() const
+		{
+			return height * width * channels;
+		}
+
+		bool valid() const
+		{
+			return channels > 0 && height > 0 && width > 0 && kernel_h > 0 && kernel_w > 0 && stride_h > 0 && stride_w > 0
+				&& pad_h >= 0 && pad_w >= 0 && kernel_h <= height + 2 * pad_h && kernel_w <= width + 2 * pad_w;
+		}
+	};
+
+	//ػʽ
+	enum class Pooling
+	{
+		max,
+		average
+	};
+
+	namespace detail
+	{
+		//im2colĻŶٸԪ
+		const std::size_t conv_block = std::size_t(1) << 20;
+
+		//һż1
+		inline int conv_block_samples(const ConvShape& g)
+		{
+			std::size_t per = (std::size_t)g.positions() * g.patch();
+			return (int)std::max<std::size_t>(1, conv_block / std::max<std::size_t>(per, 1));
+		}
+
+		//xĵs0countչcols((count*positions) x patch)Խλ0
+		template<typename T>
+		void im2col(const ConvShape& g, const Matrix2x<T>& x, int s0, int count, T* cols)
+		{
+			int oh = g.out_h();
+			int ow = g.out_w();
+			int c = g.channels;
+			int k = g.patch();
+			long long rows = (long long)count * oh * ow;
+			Eigen1::parallel_for(0, rows, 64, [&](long long lo, long long hi) {
+				for (long long r = lo; r < hi; r++)
+				{
+					int s = (int)(r / (oh * ow));
+					int pos = (int)(r % (oh * ow));
+					int oy = pos / ow;
+					int ox = pos % ow;
+					const T* src = x[s0 + s];
+					T* dst = cols + r * k;
+					for (int ky = 0; ky < g.kernel_h; ky++)
+					{
+						int iy = oy * g.stride_h - g.pad_h + ky;
+						if (iy < 0 || iy >= g.height)
+						{
+							std::fill_n(dst, g.kernel_w * c, T(0));
+							dst += g.kernel_w * c;
+							continue;
+						}
+						for (int kx = 0; kx < g.kernel_w; kx++)
+						{
+							int ix = ox * g.stride_w - g.pad_w + kx;
+							if (ix < 0 || ix >= g.width)
+							{
+								std::fill_n(dst, c, T(0));
+							}
+							else
+							{
+								std::copy_n(src + ((std::size_t)iy * g.width + ix) * c, c, dst);
+							}
+							dst += c;
+						}
+					}
+				}
+			});
+		}
+
+		//im2colķ̣dcolsۼӻdxĵs0count
+		template<typename T>
+		void col2im(const ConvShape& g, const T* dcols, int s0, int count, Matrix2x<T>& dx)
+		{
+			int oh = g.out_h();
+			int ow = g.out_w();
+			int c = g.channels;
+			int k = g.patch();
+			Eigen1::parallel_for(0, count, 1, [&](long long lo, long long hi) {
+				for (long long s = lo; s < hi; s++)
+				{
+					T* dst = dx[s0 + (int)s];
+					std::fill_n(dst, g.in_size(), T(0));
+					const T* src = dcols + s * oh * ow * k;
+					for (int oy = 0; oy < oh; oy++)
+					{
+						for (int ox = 0; ox < ow; ox++)
+						{
+							for (int ky = 0; ky < g.kernel_h; ky++)
+							{
+								int iy = oy * g.stride_h - g.pad_h + ky;
+								for (int kx = 0; kx < g.kernel_w; kx++, src += c)
+								{
+									int ix = ox * g.stride_w - g.pad_w + kx;
+									if (iy < 0 || iy >= g.height || ix < 0 || ix >= g.width)
+									{
+										continue;
+									}
+									T* p = dst + ((std::size_t)iy * g.width + ix) * c;
+									for (int ch = 0; ch < c; ch++)
+									{
+										p[ch] += src[ch];
+									}
+								}
+							}
+						}
+					}
+				}
+			});
+		}
+	}
+
+	//ά㣺ÿ(height x width x channels)ͼ(out_h x out_w x filters)
+	template<typename T>
+	class Conv2D : public Layer<T>
+	{
+	private:
+		ConvShape g;
+		int filters;
+		Activation act;
+
+		Matrix2x<T> W;//(kh*kw*channels x filters)
+		Matrix2x<T> b;//(1 x filters)
+		Matrix2x<T> dW;
+		Matrix2x<T> db;
+
+		const Matrix2x<T>* x = nullptr;//һǰ
+		Matrix2x<T> y;//
+		Matrix2x<T> dz;//ǰݶ
+		Matrix2x<T> dx;//ݶ
+
+	public:
+		//seedʼȨأreluHeʼXavierʼ
+		Conv2D(const ConvShape& shape, int num_filters, Activation activation = Activation::identity, unsigned int seed = 1)
+			:g(shape), filters(num_filters), act(activation), W(shape.patch(), num_filters), b(1, num_filters), dW(shape.patch(), num_filters), db(1, num_filters)
+		{
+			if (!g.valid())
+			{
+				std::cout << "״Ϸ" << std::endl;
+			}
+			std::mt19937 gen(seed);
+			int fan_in = g.patch();
+			T limit = act == Activation::relu ? std::sqrt(T(6) / T(fan_in)) : std::sqrt(T(6) / T(fan_in + filters));
+			std::uniform_real_distribution<T> dist(-limit, limit);
+			T* p = W.get_data();
+			for (std::size_t k = 0; k < W.size(); k++)
+			{
+				p[k] = dist(gen);
+			}
+		}
+
+		//ξˣҲͬ0
+		Conv2D(int channels, int height, int width, int num_filters, int kernel, int stride = 1, int pad = 0,
+			Activation activation = Activation::identity, unsigned int seed = 1)
+			:Conv2D(ConvShape(channels, height, width, kernel, kernel, stride, stride, pad, pad), num_filters, activation, seed) {};
+
+		const Matrix2x<T>& forward(const Matrix2x<T>& input) override
+		{
+			if (input.get_col() != get_in())
+			{
+				std::cout << "άȲһ" << std::endl;
+				return y;
+			}
+			x = AD::grad_enabled() ? &input : nullptr;
+			predict(input, y);
+			return y;
+		}
+
+		void predict(const Matrix2x<T>& input, Matrix2x<T>& output) override
+		{
+			if (input.get_col() != get_in())
+			{
+				std::cout << "άȲһ" << std::endl;
+				return;
+			}
+			int n = input.get_row();
+			if (output.get_row() != n || output.get_col() != get_out())
+			{
+				output.resize(n, get_out());
+			}
+			int pos = g.positions();
+			int nb = detail::conv_block_samples(g);
+			T* buf = Eigen1::Workspace::local().get<T>(Eigen1::Workspace::ws_conv, (std::size_t)std::min(nb, std::max(n, 1)) * pos * g.patch());
+			//ƫúͼgemmβÿλһУj˲±
+			const T* pb = b.get_data();
+			Activation a = act;
+			for (int s0 = 0; s0 < n; s0 += nb)
+			{
+				int count = std::min(nb, n - s0);
+				detail::im2col(g, input, s0, count, buf);
+				Matrix2x<T> cols = Matrix2x<T>::map(buf, count * pos, g.patch());
+				Matrix2x<T> yc = Matrix2x<T>::map(output[s0], count * pos, filters);
+				gemm(false, false, T(1), cols, W, T(0), yc, [pb, a](int, int j, T* p, int len) {
+					for (int q = 0; q < len; q++)
+					{
+						p[q] += pb[j + q];
+					}
+					detail::activate(a, p, len);
+				});
+			}
+		}
+
+		const Matrix2x<T>& backward(const Matrix2x<T>& grad_out) override
+		{
+			if (x == nullptr || grad_out.get_row() != y.get_row() || grad_out.get_col() != get_out())
+			{
+				std::cout << "㷴򴫲ʧЧǰ򲢼ݶȵ״" << std::endl;
+				return dx;
+			}
+			int n = y.get_row();
+			int pos = g.positions();
+			int out = get_out();
+			if (dz.get_row() != n || dz.get_col() != out)
+			{
+				dz.resize(n, out);
+			}
+			if (dx.get_row() != n || dx.get_col() != get_in())
+			{
+				dx.resize(n, get_in());
+			}
+			//dz = dy * act'(y)
+			Eigen1::parallel_for(0, n, 8, [&](long long lo, long long hi) {
+				for (long long i = lo; i < hi; i++)
+				{
+					detail::activate_backward(act, y[(int)i], grad_out[(int)i], dz[(int)i], out);
+				}
+			});
+			//db += dz
+			Matrix2x<T> dz_all = Matrix2x<T>::map(dz.get_data(), n * pos, filters);
+			Eigen1::col_sum(dz_all, db, true);
+			//չ룺dW += cols^T * dzȻcolsĻֱdcols = dz * W^T
+			int nb = detail::conv_block_samples(g);
+			T* buf = Eigen1::Workspace::local().get<T>(Eigen1::Workspace::ws_conv, (std::size_t)std::min(nb, std::max(n, 1)) * pos * g.patch());
+			for (int s0 = 0; s0 < n; s0 += nb)
+			{
+				int count = std::min(nb, n - s0);
+				detail::im2col(g, *x, s0, count, buf);
+				Matrix2x<T> cols = Matrix2x<T>::map(buf, count * pos, g.patch());
+				Matrix2x<T> dzc = Matrix2x<T>::map(dz[s0], count * pos, filters);
+				gemm(true, false, T(1), cols, dzc, T(1), dW);
+				gemm(false, true, T(1), dzc, W, T(0), cols);
+				detail::col2im(g, buf, s0, count, dx);
+			}
+			return dx;
+		}
+
+		void parameters(std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>>& list) override
+		{
+			list.push_back(std::make_pair(&W, &dW));
+			list.push_back(std::make_pair(&b, &db));
+		}
+
+		int get_in() const override
+		{
+			return g.in_size();
+		}
+
+		int get_out() const override
+		{
+			return g.positions() * filters;
+		}
+
+		//β
+		const ConvShape& shape() const
+		{
+			return g;
+		}
+
+		//˺ƫ
+		Matrix2x<T>& weight()
+		{
+			return W;
+		}
+		Matrix2x<T>& bias()
+		{
+			return b;
+		}
+		const Matrix2x<T>& weight_grad() const
+		{
+			return dW;
+		}
+		const Matrix2x<T>& bias_grad() const
+		{
+			return db;
+		}
+	};
+
+	//һά㣺ÿ(length x channels)źţ(out_length x filters)
+	template<typename T>
+	class Conv1D : public Conv2D<T>
+	{
+	public:
+		Conv1D(int channels, int length, int num_filters, int kernel, int stride = 1, int pad = 0,
+			Activation activation = Activation::identity, unsigned int seed = 1)
+			:Conv2D<T>(ConvShape(channels, 1, length, 1, kernel, 1, stride, 0, pad), num_filters, activation, seed) {};
+	};
+
+	//άػ㣺ÿͨϷֱȡڵֵƽֵ0
+	template<typename T>
+	class Pool2D : public Layer<T>
+	{
+	private:
+		Pooling mode;
+		ConvShape g;
+
+		bool ready = false;//һǰǷ񱣴˷ҪõĶ
+		std::vector<int> arg;//ػʱÿȡĸλ
+		Matrix2x<T> y;
+		Matrix2x<T> dx;
+
+		//pickΪʱֵλ
+		void run(const Matrix2x<T>& input, Matrix2x<T>& output, int* pick) const
+		{
+			int n = input.get_row();
+			int oh = g.out_h();
+			int ow = g.out_w();
+			int c = g.channels;
+			int out = get_out();
+			T scale = T(1) / T(g.kernel_h * g.kernel_w);
+			Eigen1::parallel_for(0, n, 4, [&](long long lo, long long hi) {
+				for (long long s = lo; s < hi; s++)
+				{
+					const T* src = input[(int)s];
+					for (int oy = 0; oy < oh; oy++)
+					{
+						for (int ox = 0; ox < ow; ox++)
+						{
+							T* dst = output[(int)s] + ((std::size_t)oy * ow + ox) * c;
+							int* at = pick ? pick + s * out + ((std::size_t)oy * ow + ox) * c : nullptr;
+							std::fill_n(dst, c, mode == Pooling::max ? std::numeric_limits<T>::lowest() : T(0));
+							for (int ky = 0; ky < g.kernel_h; ky++)
+							{
+								for (int kx = 0; kx < g.kernel_w; kx++)
+								{
+									int base = ((oy * g.stride_h + ky) * g.width + ox * g.stride_w + kx) * c;
+									const T* p = src + base;
+									if (mode == Pooling::average)
+									{
+										for (int ch = 0; ch < c; ch++)
+										{
+											dst[ch] += p[ch];
+										}
+									}
+									else if (at)
+									{
+										for (int ch = 0; ch < c; ch++)
+										{
+											if (p[ch] > dst[ch] || (ky == 0 && kx == 0))
+											{
+												dst[ch] = p[ch];
+												at[ch] = base + ch;
+											}
+										}
+									}
+									else
+									{
+										for (int ch = 0; ch < c; ch++)
+										{
+											dst[ch] = p[ch] > dst[ch] ? p[ch] : dst[ch];
+										}
+									}
+								}
+							}
+							if (mode == Pooling::average)
+							{
+								for (int ch = 0; ch < c; ch++)
+								{
+									dst[ch] *= scale;
+								}
+							}
+						}
+					}
+				}
+			});
+		}
+
+	public:
+		//strideΪ0ʱȡkernelڻص
+		Pool2D(Pooling pooling, const ConvShape& shape) :mode(pooling), g(shape)
+		{
+			if (!g.valid() || g.pad_h != 0 || g.pad_w != 0)
+			{
+				std::cout << "ػ״Ϸ" << std::endl;
+			}
+		}
+
+		Pool2D(Pooling pooling, int channels, int height, int width, int kernel, int stride = 0)
+			:Pool2D(pooling, ConvShape(channels, height, width, kernel, kernel, stride > 0 ? stride : kernel, stride > 0 ? stride : kernel)) {};
+
+		const Matrix2x<T>& forward(const Matrix2x<T>& input) override
+		{
+			if (input.get_col() != get_in())
+			{
+				std::cout << "ػάȲһ" << std::endl;
+				return y;
+			}
+			if (y.get_row() != input.get_row() || y.get_col() != get_out())
+			{
+				y.resize(input.get_row(), get_out());
+			}
+			ready = AD::grad_enabled();
+			int* pick = nullptr;
+			if (ready && mode == Pooling::max)
+			{
+				arg.resize((std::size_t)input.get_row() * get_out());
+				pick = arg.data();
+			}
+			run(input, y, pick);
+			return y;
+		}
+
+		void predict(const Matrix2x<T>& input, Matrix2x<T>& output) override
+		{
+			if (input.get_col() != get_in())
+			{
+				std::cout << "ػάȲһ" << std::endl;
+				return;
+			}
+			if (output.get_row() != input.get_row() || output.get_col() != get_out())
+			{
+				output.resize(input.get_row(), get_out());
+			}
+			run(input, output, nullptr);
+		}
+
+		const Matrix2x<T>& backward(const Matrix2x<T>& grad_out) override
+		{
+			if (!ready || grad_out.get_row() != y.get_row() || grad_out.get_col() != get_out())
+			{
+				std::cout << "ػ㷴򴫲ʧЧǰ򲢼ݶȵ״" << std::endl;
+				return dx;
+			}
+			int n = y.get_row();
+			if (dx.get_row() != n || dx.get_col() != get_in())
+			{
+				dx.resize(n, get_in());
+			}
+			int oh = g.out_h();
+			int ow = g.out_w();
+			int c = g.channels;
+			int out = get_out();
+			T scale = T(1) / T(g.kernel_h * g.kernel_w);
+			Eigen1::parallel_for(0, n, 4, [&](long long lo, long long hi) {
+				for (long long s = lo; s < hi; s++)
+				{
+					T* d = dx[(int)s];
+					const T* gy = grad_out[(int)s];
+					std::fill_n(d, get_in(), T(0));
+					if (mode == Pooling::max)
+					{
+						const int* at = arg.data() + s * out;
+						for (int k = 0; k < out; k++)
+						{
+							d[at[k]] += gy[k];
+						}
+						continue;
+					}
+					for (int oy = 0; oy < oh; oy++)
+					{
+						for (int ox = 0; ox < ow; ox++)
+						{
+							const T* p = gy + ((std::size_t)oy * ow + ox) * c;
+							for (int ky = 0; ky < g.kernel_h; ky++)
+							{
+								for (int kx = 0; kx < g.kernel_w; kx++)
+								{
+									T* q = d + ((oy * g.stride_h + ky) * g.width + ox * g.stride_w + kx) * c;
+									for (int ch = 0; ch < c; ch++)
+									{
+										q[ch] += p[ch] * scale;
+									}
+								}
+							}
+						}
+					}
+				}
+			});
+			return dx;
+		}
+
+		void parameters(std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>>&) override {};
+
+		int get_in() const override
+		{
+			return g.in_size();
+		}
+
+		int get_out() const override
+		{
+			return g.positions() * g.channels;
+		}
+
+		//β
+		const ConvShape& shape() const
+		{
+			return g;
+		}
+	};
+
+	//һάػ㣺ÿ(length x channels)ź
+	template<typename T>
+	class Pool1D : public Pool2D<T>
+	{
+	public:
+		Pool1D(Pooling pooling, int channels, int length, int kernel, int stride = 0)
+			:Pool2D<T>(pooling, ConvShape(channels, 1, length, 1, kernel, 1, stride > 0 ? stride : kernel)) {};
+	};
+}
+
+#endif // !_NN_CONV_H_
@@ -0,0 +1,282 @@
+#pragma once
+#ifndef _NN_DATA_H_
+#define _NN_DATA_H_
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+
+#include "eigen1.h"
+
+//̨ԤȡСݼ
+//̸̨߳˳򡢰һпԤȷõ
+//ѵֻܴ߳ӶȡѾװõװݺͼͬʱС
+//̶(Ĭ3飬)ʹã֮߳ߵߵζдݻš
+
+namespace NN
+{
+	using Eigen1::Matrix2x;
+
+	namespace detail
+	{
+		//ߵߵζУԪint
+		class SpscQueue
+		{
+		private:
+			//headtailֱ߳дռһУͬһ(α)
+			std::vector<int> buf;
+			alignas(64) std::atomic<std::size_t> head;//һҪλãֻд
+			alignas(64) std::atomic<std::size_t> tail;//һҪдλãֻд
+
+		public:
+			explicit SpscQueue(std::size_t capacity) :buf(capacity + 1), head(0), tail(0) {};
+
+			bool push(int v)
+			{
+				std::size_t t = tail.load(std::memory_order_relaxed);
+				std::size_t next = (t + 1) % buf.size();
+				if (next == head.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+				buf[t] = v;
+				tail.store(next, std::memory_order_release);
+				return true;
+			}
+
+			bool pop(int& v)
+			{
+				std::size_t h = head.load(std::memory_order_relaxed);
+				if (h == tail.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+				v = buf[h];
+				head.store((h + 1) % buf.size(), std::memory_order_release);
+				return true;
+			}
+		};
+
+		//Ⱦ˾óʱƬپþͶ˯ߣȴʱռһ
+		class Backoff
+		{
+		private:
+			int count = 0;
+
+		public:
+			void wait()
+			{
+				count++;
+				if (count < 64)
+				{
+					return;
+				}
+				if (count < 256)
+				{
+					std::this_thread::yield();
+					return;
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		};
+	}
+
+	template<typename T>
+	class DataLoader
+	{
+	private:
+		//һxy(batch_size)һηã
+		//һʱֻʵvxvyӳǰrowsϵͼ·
+		struct Batch
+		{
+			Matrix2x<T> x;
+			Matrix2x<T> y;
+			Matrix2x<T> vx;
+			Matrix2x<T> vy;
+			int rows = 0;
+		};
+
+		const Matrix2x<T>& src_x;
+		const Matrix2x<T>& src_y;
+		int batch_size;
+		bool shuffle;
+		bool drop_last;
+		unsigned int seed;
+
+		std::vector<Batch> slots;
+		detail::SpscQueue ready;//װõ-1ʾһ(epoch)
+		detail::SpscQueue free_slots;//ѵ߳껹
+		std::atomic<bool> stop;
+		std::thread worker;
+		int current = -1;//ѵ߳ϵ
+		Matrix2x<T> none;//ûеǰʱx()y()صĿվ󣬺̨̲߳
+
+		//ѵidx[lo, hi)пǰhi-loУviewָ⼸
+		static void gather(const Matrix2x<T>& src, const std::vector<int>& idx, int lo, int hi, Matrix2x<T>& dst, Matrix2x<T>& view)
+		{
+			int col = src.get_col();
+			for (int i = lo; i < hi; i++)
+			{
+				std::copy_n(src[idx[i]], col, dst[i - lo]);
+			}
+			if (view.get_row() != hi - lo || view.get_data() != dst.get_data())
+			{
+				view = Matrix2x<T>::map(dst.get_data(), hi - lo, col);
+			}
+		}
+
+		//̨̣߳һһֵشҡװֱ
+		void produce()
+		{
+			int n = src_x.get_row();
+			std::vector<int> idx(n);
+			std::iota(idx.begin(), idx.end(), 0);
+			std::mt19937 gen(seed);
+			int count = batch_count();
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				if (shuffle)
+				{
+					std::shuffle(idx.begin(), idx.end(), gen);
+				}
+				for (int k = 0; k < count; k++)
+				{
+					int s;
+					detail::Backoff backoff;
+					while (!free_slots.pop(s))
+					{
+						if (stop.load(std::memory_order_relaxed))
+						{
+							return;
+						}
+						backoff.wait();
+					}
+					int lo = k * batch_size;
+					int hi = std::min(n, lo + batch_size);
+					slots[s].rows = hi - lo;
+					gather(src_x, idx, lo, hi, slots[s].x, slots[s].vx);
+					if (src_y.get_row() == n)
+					{
+						gather(src_y, idx, lo, hi, slots[s].y, slots[s].vy);
+					}
+					push_ready(s);
+				}
+				push_ready(-1);
+			}
+		}
+
+		void push_ready(int v)
+		{
+			detail::Backoff backoff;
+			while (!ready.push(v))
+			{
+				if (stop.load(std::memory_order_relaxed))
+				{
+					return;
+				}
+				backoff.wait();
+			}
+		}
+
+	public:
+		//xÿһyǶӦıǩ(Դվʾûбǩ)xyȼþá
+		//buffersĿ2˫壬3
+		DataLoader(const Matrix2x<T>& x, const Matrix2x<T>& y, int size_batch, bool shuffle_data = true, bool drop_last_batch = false, int buffers = 3, unsigned int shuffle_seed = 1)
+			:src_x(x), src_y(y), batch_size(size_batch), shuffle(shuffle_data), drop_last(drop_last_batch), seed(shuffle_seed),
+			slots(std::max(buffers, 2)), ready(2 * std::max(buffers, 2) + 2), free_slots(std::max(buffers, 2)), stop(false)
+		{
+			if (y.get_row() != 0 && y.get_row() != x.get_row())
+			{
+				std::cout << "ͱǩһ£ǩ" << std::endl;
+			}
+			if (batch_size <= 0 || batch_count() == 0)
+			{
+				std::cout << "СЧһ" << std::endl;
+				return;
+			}
+			for (int s = 0; s < (int)slots.size(); s++)
+			{
+				slots[s].x.resize(batch_size, x.get_col());
+				if (y.get_row() == x.get_row())
+				{
+					slots[s].y.resize(batch_size, y.get_col());
+				}
+				free_slots.push(s);
+			}
+			worker = std::thread(&DataLoader::produce, this);
+		}
+
+		DataLoader(const DataLoader&) = delete;
+		DataLoader& operator =(const DataLoader&) = delete;
+
+		~DataLoader()
+		{
+			stop.store(true);
+			if (worker.joinable())
+			{
+				worker.join();
+			}
+		}
+
+		//ÿֵ
+		int batch_count() const
+		{
+			if (batch_size <= 0)
+			{
+				return 0;
+			}
+			int n = src_x.get_row();
+			return drop_last ? n / batch_size : (n + batch_size - 1) / batch_size;
+		}
+
+		//ȡһһĻͬʱ̨̣߳һֽʱfalseٵþͿʼһ
+		bool next()
+		{
+			if (current >= 0)
+			{
+				free_slots.push(current);
+				current = -1;
+			}
+			if (!worker.joinable())
+			{
+				return false;
+			}
+			int s;
+			detail::Backoff backoff;
+			while (!ready.pop(s))
+			{
+				backoff.wait();
+			}
+			if (s < 0)
+			{
+				return false;
+			}
+			current = s;
+			return true;
+		}
+
+		//ǰͱǩһnext()֮ǰЧ
+		//ûеǰ(һnext()֮ǰһֽ֮)ʱؿվʱ黺̨߳д
+		const Matrix2x<T>& x() const
+		{
+			return current < 0 ? none : slots[current].vx;
+		}
+		const Matrix2x<T>& y() const
+		{
+			return current < 0 ? none : slots[current].vy;
+		}
+
+		//ǰʵֻвһСС
+		int rows() const
+		{
+			return current < 0 ? 0 : slots[current].rows;
+		}
+	};
+}
+
+#endif // !_NN_DATA_H_
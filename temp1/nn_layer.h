@@ -0,0 +1,494 @@
+#pragma once
+#ifndef _NN_LAYER_H_
+#define _NN_LAYER_H_
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include "eigen1.h"
+#include "eigen1_parallel.h"
+#include "eigen1_reduce.h"
+#include "grad_mode.h"
+
+//Matrix2xϴ㡣
+//һСдţX(batch x in)ÿһ
+//Denseǰ Y = act(X * W + b) ֱ÷ֿgemmÿСgemmepilogue͵ؼƫá
+//ٵɨ飻󼤻ǰݶdZδתñ־gemm dX = dZ * W^T  dW += X^T * dZ
+//ÿݶȶڲԼԤȷõĻСʱѵѭﲻٷڴ档
+//NoGradGuardǰʱ淴Ҫõ룬Sequentialֻ黺صռø
+
+namespace NN
+{
+	using Eigen1::Matrix2x;
+	using AD::NoGradGuard;
+
+	//
+	enum class Activation
+	{
+		identity,
+		relu,
+		sigmoid,
+		tanh
+	};
+
+	namespace detail
+	{
+		//һݾ͵
+		template<typename T>
+		inline void activate(Activation act, T* p, int n)
+		{
+			switch (act)
+			{
+			case Activation::relu:
+				for (int j = 0; j < n; j++)
+				{
+					p[j] = p[j] > T(0) ? p[j] : T(0);
+				}
+				break;
+			case Activation::sigmoid:
+				for (int j = 0; j < n; j++)
+				{
+					p[j] = T(1) / (T(1) + std::exp(-p[j]));
+				}
+				break;
+			case Activation::tanh:
+				for (int j = 0; j < n; j++)
+				{
+					p[j] = std::tanh(p[j]);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		//dz = dy * act'(z)üyʾǰz
+		template<typename T>
+		inline void activate_backward(Activation act, const T* y, const T* dy, T* dz, int n)
+		{
+			switch (act)
+			{
+			case Activation::relu:
+				for (int j = 0; j < n; j++)
+				{
+					dz[j] = y[j] > T(0) ? dy[j] : T(0);
+				}
+				break;
+			case Activation::sigmoid:
+				for (int j = 0; j < n; j++)
+				{
+					dz[j] = dy[j] * y[j] * (T(1) - y[j]);
+				}
+				break;
+			case Activation::tanh:
+				for (int j = 0; j < n; j++)
+				{
+					dz[j] = dy[j] * (T(1) - y[j] * y[j]);
+				}
+				break;
+			default:
+				for (int j = 0; j < n; j++)
+				{
+					dz[j] = dy[j];
+				}
+				break;
+			}
+		}
+	}
+
+	//һ(, ݶ)ĴԭľΪӳ䵽ϵͼ
+	//Żһɨвߡ
+	//ÿ㰴64ֽڶ룬мճλֵݶȶ0ҲӰ
+	template<typename T>
+	class ParameterSet
+	{
+	private:
+		Eigen1::aligned_vector<T> value;
+		Eigen1::aligned_vector<T> grad;
+		std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>> list;
+		std::size_t generation = 0;//ÿɹbindһμ1ŻݴжҪҪ״̬
+
+	public:
+		ParameterSet() {};
+		explicit ParameterSet(const std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>>& params)
+		{
+			bind(params);
+		}
+		ParameterSet(const ParameterSet&) = delete;
+		ParameterSet& operator =(const ParameterSet&) = delete;
+
+		//ӹparamsľ󣺵ǰֵݶȿ飬ȻѾ󻻳ͼ
+		//ظãɵĴо󻻰֮ͷ
+		void bind(const std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>>& params)
+		{
+			const std::size_t step = Eigen1::memory_align / sizeof(T) > 0 ? Eigen1::memory_align / sizeof(T) : 1;
+			std::vector<std::size_t> offset;
+			std::size_t total = 0;
+			for (const auto& p : params)
+			{
+				if (p.first->get_row() != p.second->get_row() || p.first->get_col() != p.second->get_col())
+				{
+					std::cout << "ݶȵ״һ" << std::endl;
+					return;
+				}
+				offset.push_back(total);
+				total += (p.first->size() + step - 1) / step * step;
+			}
+			Eigen1::aligned_vector<T> new_value(total, T(0));
+			Eigen1::aligned_vector<T> new_grad(total, T(0));
+			for (std::size_t i = 0; i < params.size(); i++)
+			{
+				Matrix2x<T>& w = *params[i].first;
+				Matrix2x<T>& g = *params[i].second;
+				std::copy_n(w.get_data(), w.size(), new_value.data() + offset[i]);
+				std::copy_n(g.get_data(), g.size(), new_grad.data() + offset[i]);
+				w = Matrix2x<T>::map(new_value.data() + offset[i], w.get_row(), w.get_col());
+				g = Matrix2x<T>::map(new_grad.data() + offset[i], g.get_row(), g.get_col());
+			}
+			value.swap(new_value);
+			grad.swap(new_grad);
+			list = params;
+			generation++;
+		}
+
+		//Ԫ(λ)
+		std::size_t size() const
+		{
+			return value.size();
+		}
+
+		//ݶȵ
+		T* get_value()
+		{
+			return value.data();
+		}
+		T* get_grad()
+		{
+			return grad.data();
+		}
+
+		//ݶ
+		void zero_grad()
+		{
+			std::fill(grad.begin(), grad.end(), T(0));
+		}
+
+		//󶨽(, ݶ)
+		const std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>>& parameters() const
+		{
+			return list;
+		}
+
+		//󶨵Ĵ֮(Ԫ)ͺ֮ǰͬ
+		std::size_t get_generation() const
+		{
+			return generation;
+		}
+	};
+
+	//Ĺӿ
+	template<typename T>
+	class Layer
+	{
+	public:
+		virtual ~Layer() {};
+
+		//ǰ򣬷زڲxbackward֮ǰ뱣Ч
+		virtual const Matrix2x<T>& forward(const Matrix2x<T>& x) = 0;
+
+		//ֵֻǰ򣬽дout(״ʱ·)κηҪõĶ
+		virtual void predict(const Matrix2x<T>& x, Matrix2x<T>& out) = 0;
+
+		//ݶȣݶۼӵڲضݶ
+		virtual const Matrix2x<T>& backward(const Matrix2x<T>& grad_out) = 0;
+
+		//(, ݶ)׷ӵlist
+		virtual void parameters(std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>>& list) = 0;
+
+		//롢
+		virtual int get_in() const = 0;
+		virtual int get_out() const = 0;
+	};
+
+	//ȫӲ㣺Y = act(X * W + b)W(in x out)b(1 x out)
+	template<typename T>
+	class Dense : public Layer<T>
+	{
+	private:
+		int in;
+		int out;
+		Activation act;
+
+		Matrix2x<T> W;
+		Matrix2x<T> b;
+		Matrix2x<T> dW;
+		Matrix2x<T> db;
+
+		const Matrix2x<T>* x = nullptr;//һǰ
+		Matrix2x<T> y;//
+		Matrix2x<T> dz;//ǰݶ
+		Matrix2x<T> dx;//ݶ
+
+	public:
+		//seedʼȨأreluHeʼXavierʼ
+		Dense(int size_in, int size_out, Activation activation = Activation::identity, unsigned int seed = 1)
+			:in(size_in), out(size_out), act(activation), W(size_in, size_out), b(1, size_out), dW(size_in, size_out), db(1, size_out)
+		{
+			std::mt19937 gen(seed);
+			T limit = act == Activation::relu ? std::sqrt(T(6) / T(in)) : std::sqrt(T(6) / T(in + out));
+			std::uniform_real_distribution<T> dist(-limit, limit);
+			T* p = W.get_data();
+			for (std::size_t k = 0; k < W.size(); k++)
+			{
+				p[k] = dist(gen);
+			}
+		}
+
+		const Matrix2x<T>& forward(const Matrix2x<T>& input) override
+		{
+			if (input.get_col() != in)
+			{
+				std::cout << "DenseάȲһ" << std::endl;
+				return y;
+			}
+			x = AD::grad_enabled() ? &input : nullptr;
+			predict(input, y);
+			return y;
+		}
+
+		void predict(const Matrix2x<T>& input, Matrix2x<T>& output) override
+		{
+			if (input.get_col() != in)
+			{
+				std::cout << "DenseάȲһ" << std::endl;
+				return;
+			}
+			if (output.get_row() != input.get_row() || output.get_col() != out)
+			{
+				output.resize(input.get_row(), out);
+			}
+			const T* pb = b.get_data();
+			Activation a = act;
+			gemm(false, false, T(1), input, W, T(0), output, [pb, a](int, int j, T* p, int len) {
+				for (int q = 0; q < len; q++)
+				{
+					p[q] += pb[j + q];
+				}
+				detail::activate(a, p, len);
+			});
+		}
+
+		const Matrix2x<T>& backward(const Matrix2x<T>& grad_out) override
+		{
+			if (x == nullptr || grad_out.get_row() != y.get_row() || grad_out.get_col() != out)
+			{
+				std::cout << "Dense㷴򴫲ʧЧǰ򲢼ݶȵ״" << std::endl;
+				return dx;
+			}
+			int n = y.get_row();
+			if (dz.get_row() != n || dz.get_col() != out)
+			{
+				dz.resize(n, out);
+			}
+			if (dx.get_row() != n || dx.get_col() != in)
+			{
+				dx.resize(n, in);
+			}
+			//dz = dy * act'(y)
+			Eigen1::parallel_for(0, n, 8, [&](long long lo, long long hi) {
+				for (long long i = lo; i < hi; i++)
+				{
+					detail::activate_backward(act, y[(int)i], grad_out[(int)i], dz[(int)i], out);
+				}
+			});
+			//dx = dz * W^TdW += X^T * dzתögemmڴʱ
+			gemm(false, true, T(1), dz, W, T(0), dx);
+			gemm(true, false, T(1), *x, dz, T(1), dW);
+			//db += dz
+			Eigen1::col_sum(dz, db, true);
+			return dx;
+		}
+
+		void parameters(std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>>& list) override
+		{
+			list.push_back(std::make_pair(&W, &dW));
+			list.push_back(std::make_pair(&b, &db));
+		}
+
+		int get_in() const override
+		{
+			return in;
+		}
+
+		int get_out() const override
+		{
+			return out;
+		}
+
+		//Ȩغƫ
+		Matrix2x<T>& weight()
+		{
+			return W;
+		}
+		Matrix2x<T>& bias()
+		{
+			return b;
+		}
+		const Matrix2x<T>& weight_grad() const
+		{
+			return dW;
+		}
+		const Matrix2x<T>& bias_grad() const
+		{
+			return db;
+		}
+	};
+
+	//˳Ķ
+	template<typename T>
+	class Sequential
+	{
+	private:
+		ParameterSet<T> params;//layersǰ棬֤ڴ
+		std::vector<std::unique_ptr<Layer<T>>> layers;
+
+		//ʱǰõ黺ӳ䵽
+		Eigen1::aligned_vector<T> infer_buf[2];
+		Matrix2x<T> infer_out[2];
+
+	public:
+		Sequential() {};
+		Sequential(const Sequential&) = delete;
+		Sequential& operator =(const Sequential&) = delete;
+
+		//ĩβһ㣬һ
+		template<typename L, typename... Args>
+		L& add(Args&&... args)
+		{
+			L* p = new L(std::forward<Args>(args)...);
+			if (!layers.empty() && layers.back()->get_out() != p->get_in())
+			{
+				std::cout << "¼ĲάһάȲһ" << std::endl;
+			}
+			layers.push_back(std::unique_ptr<Layer<T>>(p));
+			return *p;
+		}
+
+		//
+		int size() const
+		{
+			return (int)layers.size();
+		}
+
+		//ȡi
+		Layer<T>& operator [](int i)
+		{
+			return *layers[i];
+		}
+
+		//ǰ򣬷һ
+		//NoGradGuardֻ黺صصĽһǰ֮ǰЧ
+		const Matrix2x<T>& forward(const Matrix2x<T>& x)
+		{
+			const Matrix2x<T>* p = &x;
+			if (!AD::grad_enabled())
+			{
+				std::size_t width = 0;
+				for (auto& l : layers)
+				{
+					width = std::max(width, (std::size_t)l->get_out());
+				}
+				std::size_t need = (std::size_t)x.get_row() * width;
+				for (int k = 0; k < 2; k++)
+				{
+					if (infer_buf[k].size() < need)
+					{
+						infer_out[k] = Matrix2x<T>();
+						infer_buf[k].assign(need, T(0));
+					}
+				}
+				for (std::size_t i = 0; i < layers.size(); i++)
+				{
+					Matrix2x<T>& out = infer_out[i % 2];
+					if (out.is_owner() || out.get_row() != x.get_row() || out.get_col() != layers[i]->get_out())
+					{
+						out = Matrix2x<T>::map(infer_buf[i % 2].data(), x.get_row(), layers[i]->get_out());
+					}
+					layers[i]->predict(*p, out);
+					p = &out;
+				}
+				return *p;
+			}
+			for (auto& l : layers)
+			{
+				p = &l->forward(*p);
+			}
+			return *p;
+		}
+
+		//򣬲ݶۼӵ㣬ضݶ
+		const Matrix2x<T>& backward(const Matrix2x<T>& grad_out)
+		{
+			const Matrix2x<T>* p = &grad_out;
+			for (auto it = layers.rbegin(); it != layers.rend(); ++it)
+			{
+				p = &(*it)->backward(*p);
+			}
+			return *p;
+		}
+
+		//в(, ݶ)
+		std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>> parameters()
+		{
+			std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>> list;
+			for (auto& l : layers)
+			{
+				l->parameters(list);
+			}
+			return list;
+		}
+
+		//вݶȰļϣŻã²֮ٵû°
+		ParameterSet<T>& flat_parameters()
+		{
+			std::vector<std::pair<Matrix2x<T>*, Matrix2x<T>*>> list = parameters();
+			if (list != params.parameters())
+			{
+				params.bind(list);
+			}
+			return params;
+		}
+	};
+
+	//ʧ 0.5 * mean(sum((y - t)^2))ͬʱѶyݶдgrad(״ʱ·)
+	template<typename T>
+	T mse_loss(const Matrix2x<T>& y, const Matrix2x<T>& target, Matrix2x<T>& grad)
+	{
+		if (y.get_row() != target.get_row() || y.get_col() != target.get_col())
+		{
+			std::cout << "ʧĿ״һ" << std::endl;
+			return T(0);
+		}
+		if (grad.get_row() != y.get_row() || grad.get_col() != y.get_col())
+		{
+			grad.resize(y.get_row(), y.get_col());
+		}
+		T scale = T(1) / T(y.get_row());
+		const T* py = y.get_data();
+		const T* pt = target.get_data();
+		T* pg = grad.get_data();
+		for (std::size_t k = 0; k < y.size(); k++)
+		{
+			pg[k] = (py[k] - pt[k]) * scale;
+		}
+		//loss = 0.5 * sum(d^2) / n = 0.5 * n * sum(grad^2)ƽֱóɶۼ
+		return T(0.5) * T(y.get_row()) * Eigen1::squared_norm(grad);
+	}
+}
+
+#endif // !_NN_LAYER_H_
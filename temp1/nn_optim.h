@@ -0,0 +1,174 @@
+#pragma once
+#ifndef _NN_OPTIM_H_
+#define _NN_OPTIM_H_
+
+#include <cmath>
+#include <iostream>
+
+#include "eigen1_memory.h"
+#include "eigen1_parallel.h"
+#include "nn_layer.h"
+
+//ŻݶȡŻ״̬(Adamһ׶׾)ParameterSet飬
+//һstep()Ƕ⼸һԪɨ裺²ͬʱݶ㣬
+//ضдܶʱһɨڴƣָ̡߳
+
+namespace NN
+{
+	namespace detail
+	{
+		//ÿ߳ٷֵôԪزſ߳
+		const long long optim_grain = 1 << 15;
+	}
+
+	template<typename T>
+	class Optimizer
+	{
+	protected:
+		ParameterSet<T>& params;
+		T lr;
+		std::size_t bound_generation;//״̬Ӧǲϵĵڼΰ
+
+		//stepͷãϴstep֮°󶨹(Ԫû䣬Ѿһ)
+		//reset()״̬ðѾɲĶعõ²
+		void check_binding()
+		{
+			if (bound_generation != params.get_generation())
+			{
+				bound_generation = params.get_generation();
+				reset();
+			}
+		}
+
+		//״̬ĳȸŲߣյ(չreset)ʱ
+		void fit_state(Eigen1::aligned_vector<T>& state)
+		{
+			if (state.size() != params.size())
+			{
+				state.assign(params.size(), T(0));
+			}
+		}
+
+	public:
+		Optimizer(ParameterSet<T>& p, T learning_rate) :params(p), lr(learning_rate), bound_generation(p.get_generation()) {};
+		virtual ~Optimizer() {};
+
+		//õǰݶȸһβݶ
+		virtual void step() = 0;
+
+		//Ż״̬(عơ)°󶨺ĵһstepԶ
+		virtual void reset() = 0;
+
+		//ѧϰ
+		T get_lr() const
+		{
+			return lr;
+		}
+		void set_lr(T learning_rate)
+		{
+			lr = learning_rate;
+		}
+	};
+
+	//SGDv = momentum * v + (g + weight_decay * w)w -= lr * v
+	template<typename T>
+	class SGD : public Optimizer<T>
+	{
+	private:
+		T momentum;
+		T weight_decay;
+		Eigen1::aligned_vector<T> velocity;
+
+	public:
+		SGD(ParameterSet<T>& p, T learning_rate, T momentum_rate = T(0), T decay = T(0))
+			:Optimizer<T>(p, learning_rate), momentum(momentum_rate), weight_decay(decay) {};
+
+		void step() override
+		{
+			this->check_binding();
+			this->fit_state(velocity);
+			T* w = this->params.get_value();
+			T* g = this->params.get_grad();
+			T* v = velocity.data();
+			const T lr = this->lr;
+			const T mu = momentum;
+			const T wd = weight_decay;
+			Eigen1::parallel_for(0, (long long)this->params.size(), detail::optim_grain, [=](long long lo, long long hi) {
+				for (long long i = lo; i < hi; i++)
+				{
+					T d = g[i] + wd * w[i];
+					T vi = mu * v[i] + d;
+					v[i] = vi;
+					w[i] -= lr * vi;
+					g[i] = T(0);
+				}
+			});
+		}
+
+		//ն
+		void reset() override
+		{
+			velocity.clear();
+		}
+	};
+
+	//Adamm = b1*m + (1-b1)*gv = b2*v + (1-b2)*g^2w -= lr * m_hat / (sqrt(v_hat) + eps)
+	//ƫϵÿֻһΣѭֻʣ˼Ӻһο
+	template<typename T>
+	class Adam : public Optimizer<T>
+	{
+	private:
+		T beta1;
+		T beta2;
+		T eps;
+		T weight_decay;
+		long long t = 0;//Ѿ߹Ĳ
+		Eigen1::aligned_vector<T> m;
+		Eigen1::aligned_vector<T> v;
+
+	public:
+		Adam(ParameterSet<T>& p, T learning_rate = T(0.001), T b1 = T(0.9), T b2 = T(0.999), T epsilon = T(1e-8), T decay = T(0))
+			:Optimizer<T>(p, learning_rate), beta1(b1), beta2(b2), eps(epsilon), weight_decay(decay) {};
+
+		void step() override
+		{
+			this->check_binding();
+			this->fit_state(m);
+			this->fit_state(v);
+			t++;
+			T* w = this->params.get_value();
+			T* g = this->params.get_grad();
+			T* pm = m.data();
+			T* pv = v.data();
+			const T b1 = beta1;
+			const T b2 = beta2;
+			const T e = eps;
+			const T wd = weight_decay;
+			//m_hat / (sqrt(v_hat) + eps) = a * m / (sqrt(v) * s + eps)
+			const T a = this->lr / (T(1) - std::pow(b1, (T)t));
+			const T s = T(1) / std::sqrt(T(1) - std::pow(b2, (T)t));
+			Eigen1::parallel_for(0, (long long)this->params.size(), detail::optim_grain, [=](long long lo, long long hi) {
+				for (long long i = lo; i < hi; i++)
+				{
+					T gi = g[i] + wd * w[i];
+					T mi = b1 * pm[i] + (T(1) - b1) * gi;
+					T vi = b2 * pv[i] + (T(1) - b2) * gi * gi;
+					pm[i] = mi;
+					pv[i] = vi;
+					w[i] -= a * mi / (std::sqrt(vi) * s + e);
+					g[i] = T(0);
+				}
+			});
+		}
+
+		//¿ʼվع
+		void reset() override
+		{
+			t = 0;
+			m.clear();
+			v.clear();
+		}
+	};
+}
+
+#endif // !_NN_OPTIM_H_
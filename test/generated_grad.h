@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+//AD::TapeɵĴ룺22ڵ㣬3
+inline double generated_grad(const double* x, double* grad)
+{
+	const double v0 = x[0];
+	const double v1 = x[1];
+	const double v2 = v0 * v1;
+	const double v3 = std::sin(v2);
+	const double v4 = x[2];
+	const double v5 = 2.0;
+	const double v6 = v0 + v5;
+	const double v7 = v4 / v6;
+	const double v8 = std::exp(v7);
+	const double v9 = v8 * v1;
+	const double v10 = v3 + v9;
+	const double v11 = std::pow(v1, v4);
+	const double v12 = v10 - v11;
+	const double v13 = v0 * v0;
+	const double v14 = 1.0;
+	const double v15 = v13 + v14;
+	const double v16 = std::log(v15);
+	const double v17 = v12 + v16;
+	const double v18 = 3.75;
+	const double v19 = v0 * v18;
+	const double v20 = v19 / v4;
+	const double v21 = v17 + v20;
+	if (grad == nullptr)
+	{
+		return v21;
+	}
+	double a21 = 1;
+	double a17 = a21;
+	double a20 = a21;
+	double a19 = a20 / v4;
+	double a4 = -a20 * v19 / (v4 * v4);
+	double a0 = a19 * v18;
+	double a12 = a17;
+	double a16 = a17;
+	double a15 = a16 / v15;
+	double a13 = a15;
+	a0 += a13 * v0;
+	a0 += a13 * v0;
+	double a10 = a12;
+	double a11 = -a12;
+	double a1 = a11 * (v4 * std::pow(v1, v4 - 1));
+	a4 += a11 * (v11 * std::log(v1));
+	double a3 = a10;
+	double a9 = a10;
+	double a8 = a9 * v1;
+	a1 += a9 * v8;
+	double a7 = a8 * v8;
+	a4 += a7 / v6;
+	double a6 = -a7 * v4 / (v6 * v6);
+	a0 += a6;
+	double a2 = a3 * std::cos(v2);
+	a0 += a2 * v1;
+	a1 += a2 * v0;
+	grad[0] = a0;
+	grad[1] = a1;
+	grad[2] = a4;
+	return v21;
+}
@@ -0,0 +1,1115 @@
+﻿//自检程序：把各部分的结果和最直接的参照算法(三重循环、有限差分、逐个标量反向传播)对比，
+//误差超过容差就记一次失败。全部通过返回0，否则返回失败的项数，可以直接放进构建后的检查步骤里。
+//每块功能一个test_函数(矩阵基本运算、gemm、求逆、求解器、磁带、雅可比、各层梯度……)，main里依次调用；
+//修过的问题都在对应的函数里留一条回归检查。
+//用法：test
+
+//打开分配计数，并替换全局operator new来数堆分配(整个程序只有这一个.cpp这样做)
+#define EIGEN1_STATS
+#define EIGEN1_STATS_COUNT_HEAP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "eigen1.h"
+#include "eigen1_fixed.h"
+#include "eigen1_batch.h"
+#include "eigen1_solver.h"
+#include "eigen1_reduce.h"
+#include "autodiff.h"
+#include "autodiff_tape.h"
+#include "autodiff_jacobian.h"
+#include "nn_layer.h"
+#include "nn_conv.h"
+#include "eigen1_sparse.h"
+#include "eigen1_memory.h"
+#include "eigen1_io.h"
+#include "nn_optim.h"
+#include "nn_data.h"
+#include "grad_mode.h"
+#include "eigen1_quant.h"
+#include "eigen1_stats.h"
+#include "autodiff_codegen.h"
+#include "generated_grad.h"
+
+using Eigen1::Matrix2x;
+
+namespace
+{
+	int failures = 0;
+
+	//记录一项检查的结果
+	void check(const std::string& name, double err, double tol)
+	{
+		bool good = err <= tol;
+		std::cout << (good ? "通过  " : "失败  ") << name << "  误差 " << err << "  容差 " << tol << std::endl;
+		if (!good)
+		{
+			failures++;
+		}
+	}
+
+	void fill(Matrix2x<double>& m, unsigned int seed)
+	{
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<double> dist(-1.0, 1.0);
+		double* p = m.get_data();
+		for (std::size_t k = 0; k < m.size(); k++)
+		{
+			p[k] = dist(gen);
+		}
+	}
+
+	//三重循环的参照乘法：alpha * op(a) * op(b) + beta * c
+	Matrix2x<double> reference_gemm(bool trans_a, bool trans_b, double alpha, const Matrix2x<double>& a, const Matrix2x<double>& b, double beta, const Matrix2x<double>& c)
+	{
+		int m = trans_a ? a.get_col() : a.get_row();
+		int k = trans_a ? a.get_row() : a.get_col();
+		int n = trans_b ? b.get_row() : b.get_col();
+		Matrix2x<double> ends(m, n);
+		for (int i = 0; i < m; i++)
+		{
+			for (int j = 0; j < n; j++)
+			{
+				double s = 0;
+				for (int p = 0; p < k; p++)
+				{
+					s += (trans_a ? a[p][i] : a[i][p]) * (trans_b ? b[j][p] : b[p][j]);
+				}
+				ends[i][j] = alpha * s + beta * c[i][j];
+			}
+		}
+		return ends;
+	}
+
+	double max_diff(const Matrix2x<double>& a, const Matrix2x<double>& b)
+	{
+		if (a.get_row() != b.get_row() || a.get_col() != b.get_col())
+		{
+			return 1e300;
+		}
+		double e = 0;
+		for (std::size_t k = 0; k < a.size(); k++)
+		{
+			e = std::max(e, std::abs(a.get_data()[k] - b.get_data()[k]));
+		}
+		return e;
+	}
+
+	void test_gemm()
+	{
+		//小尺寸走直接循环，大尺寸走打包的分块核，奇数尺寸覆盖边角
+		int shapes[][3] = { { 3, 5, 4 }, { 67, 45, 130 }, { 130, 70, 300 } };
+		for (auto& s : shapes)
+		{
+			for (int t = 0; t < 4; t++)
+			{
+				bool ta = (t & 1) != 0;
+				bool tb = (t & 2) != 0;
+				int m = s[0], n = s[1], k = s[2];
+				Matrix2x<double> a(ta ? k : m, ta ? m : k), b(tb ? n : k, tb ? k : n), c(m, n);
+				fill(a, 1);
+				fill(b, 2);
+				fill(c, 3);
+				Matrix2x<double> ref = reference_gemm(ta, tb, 0.5, a, b, 2.0, c);
+				gemm(ta, tb, 0.5, a, b, 2.0, c);
+				check("gemm " + std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k) + " trans " + std::to_string(ta) + std::to_string(tb), max_diff(c, ref), 1e-12 * k);
+			}
+		}
+		//收尾：每个元素只被加一次偏置
+		Matrix2x<double> a(90, 300), b(300, 70), c(90, 70);
+		fill(a, 4);
+		fill(b, 5);
+		Matrix2x<double> ref = reference_gemm(false, false, 1.0, a, b, 0.0, c);
+		gemm(false, false, 1.0, a, b, 0.0, c, [](int, int, double* p, int len) {
+			for (int q = 0; q < len; q++)
+			{
+				p[q] += 1.0;
+			}
+		});
+		for (std::size_t q = 0; q < ref.size(); q++)
+		{
+			ref.get_data()[q] += 1.0;
+		}
+		check("gemm epilogue", max_diff(c, ref), 1e-10);
+	}
+
+	void test_inverse()
+	{
+		std::mt19937 gen(7);
+		std::uniform_real_distribution<double> dist(-1.0, 1.0);
+		Eigen1::Matrix<double, 4, 4> m;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				m[i][j] = dist(gen) + (i == j ? 4.0 : 0.0);
+			}
+		}
+		Eigen1::Matrix<double, 4, 4> p = m * m.inv();
+		double e = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				e = std::max(e, std::abs(p[i][j] - (i == j ? 1.0 : 0.0)));
+			}
+		}
+		check("定长4x4求逆", e, 1e-12);
+
+		//奇异判定相对于矩阵的大小：0.03*I(行列式约8.1e-7)可逆，秩亏的矩阵不管放大多少倍都是奇异
+		Eigen1::Matrix<double, 4, 4> small('I');
+		small *= 0.03;
+		Eigen1::Matrix<double, 4, 4> small_inv = small.inv();
+		e = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				e = std::max(e, std::abs(small_inv[i][j] - (i == j ? 1.0 / 0.03 : 0.0)));
+			}
+		}
+		Eigen1::Matrix<double, 3, 3> rank2;
+		for (int j = 0; j < 3; j++)
+		{
+			rank2[0][j] = 1e4 * (j + 1);
+			rank2[1][j] = 1e4 * (j + 2);
+			rank2[2][j] = 1e4 * (2 * j + 3);
+		}
+		double dummy[9];
+		bool rejected = !Eigen1::detail::fixed_inv<double, 3>::inv(rank2[0], dummy);
+		check("定长求逆按相对阈值判奇异", rejected ? e : 1e300, 1e-9);
+
+		int n = 1000;
+		Eigen1::MatrixBatch<double, 3, 3> a(n);
+		Eigen1::MatrixBatch<double, 3, 1> y(n), x;
+		for (int b = 0; b < n; b++)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					a.at(b, i, j) = dist(gen) + (i == j ? 3.0 : 0.0);
+				}
+				y.at(b, i, 0) = dist(gen);
+			}
+		}
+		//第0个矩阵改成奇异的，应当被标记出来
+		for (int j = 0; j < 3; j++)
+		{
+			a.at(0, 2, j) = a.at(0, 1, j);
+		}
+		std::vector<char> ok(n);
+		Eigen1::batch_solve(a, y, x, reinterpret_cast<bool*>(ok.data()));
+		e = 0;
+		for (int b = 1; b < n; b++)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				double s = 0;
+				for (int j = 0; j < 3; j++)
+				{
+					s += a.at(b, i, j) * x.at(b, j, 0);
+				}
+				e = std::max(e, std::abs(s - y.at(b, i, 0)));
+			}
+		}
+		check("批量3x3解方程", e, 1e-12);
+		check("批量求逆标记奇异矩阵", (!ok[0] && std::count(ok.begin() + 1, ok.end(), 1) == n - 1) ? 0.0 : 1.0, 0.0);
+
+		//数值小但条件数好的矩阵不能被逐通道地判成奇异
+		Eigen1::MatrixBatch<double, 2, 2> tiny(40), tiny_inv;
+		for (int b = 0; b < 40; b++)
+		{
+			double s = 1e-4 * (b + 1);
+			tiny.at(b, 0, 0) = 2 * s;
+			tiny.at(b, 0, 1) = s;
+			tiny.at(b, 1, 0) = s;
+			tiny.at(b, 1, 1) = 3 * s;
+		}
+		std::vector<char> tiny_ok(40);
+		batch_inv(tiny, tiny_inv, reinterpret_cast<bool*>(tiny_ok.data()));
+		e = 0;
+		for (int b = 0; b < 40; b++)
+		{
+			double s = 1e-4 * (b + 1);
+			e = std::max(e, std::abs(tiny_inv.at(b, 0, 0) * 5 * s - 3.0) + std::abs(tiny_inv.at(b, 0, 1) * 5 * s + 1.0));
+		}
+		check("批量求逆按相对阈值判奇异", std::count(tiny_ok.begin(), tiny_ok.end(), 1) == 40 ? e : 1e300, 1e-12);
+	}
+
+	void test_solver()
+	{
+		//对称正定：A = M^T * M + n * I
+		int n = 150;
+		Matrix2x<double> m(n, n), a(n, n), b(n, 3);
+		fill(m, 8);
+		fill(b, 9);
+		gemm(true, false, 1.0, m, m, 0.0, a);
+		for (int i = 0; i < n; i++)
+		{
+			a[i][i] += n;
+		}
+		Eigen1::Cholesky<double> chol(a);
+		Matrix2x<double> x = chol.solve(b);
+		Matrix2x<double> r = a * x;
+		check("Cholesky求解", chol.is_ok() ? max_diff(r, b) : 1e300, 1e-10);
+
+		//尾部更新按三角形面积分段：各段工作量相近，多线程的结果和单线程一致
+		double lightest = 1e300, heaviest = 0;
+		for (int id = 0; id < 4; id++)
+		{
+			long long lo = Eigen1::detail::triangle_split(1000, id, 4);
+			long long hi = Eigen1::detail::triangle_split(1000, id + 1, 4);
+			double area = (double)(hi * (hi + 1) - lo * (lo + 1)) / 2;
+			lightest = std::min(lightest, area);
+			heaviest = std::max(heaviest, area);
+		}
+		check("Cholesky尾部更新的分段均衡", heaviest / lightest - 1, 0.01);
+		Eigen1::set_num_threads(4);
+		Eigen1::Cholesky<double> chol4(a);
+		Eigen1::set_num_threads(0);
+		check("set_num_threads(4)时的Cholesky", chol4.is_ok() ? max_diff(chol4.solve(b), x) : 1e300, 1e-12);
+
+		//最小二乘：残差和列空间正交，A^T * (A * x - b) = 0
+		int rows = 300, cols = 80;
+		Matrix2x<double> q(rows, cols), qb(rows, 2);
+		fill(q, 10);
+		fill(qb, 11);
+		Eigen1::HouseholderQR<double> qr(q);
+		Matrix2x<double> qx = qr.solve(qb);
+		Matrix2x<double> res = q * qx;
+		res -= qb;
+		Matrix2x<double> normal(cols, 2);
+		gemm(true, false, 1.0, q, res, 0.0, normal);
+		check("QR最小二乘", qr.is_ok() ? Eigen1::norm_inf(normal) : 1e300, 1e-10);
+	}
+
+	//测试用的标量函数，输入3个
+	template<typename V>
+	V scalar_function(const V& x, const V& y, const V& z)
+	{
+		return sin(x * y) + exp(z / (x + V(2.0))) * y - pow(y, z) + log(x * x + V(1.0));
+	}
+
+	void test_tape()
+	{
+		AD::Var<double> x(0.4), y(1.3), z(0.7);
+		AD::Var<double> f = scalar_function(x, y, z);
+		f.backward();
+		double ref[3] = { x.get_deriv(), y.get_deriv(), z.get_deriv() };
+
+		AD::Tape<double> tape(f, { x, y, z });
+		double in[3] = { 0.4, 1.3, 0.7 };
+		double grad[3];
+		double value = tape.gradient(in, grad);
+		double e = std::abs(value - f.get_value());
+		for (int k = 0; k < 3; k++)
+		{
+			e = std::max(e, std::abs(grad[k] - ref[k]));
+		}
+		check("磁带求值和梯度", e, 1e-12);
+
+		//换一组输入，和重新建图的结果比
+		double in2[3] = { -0.2, 0.9, 1.1 };
+		AD::Var<double> x2(in2[0]), y2(in2[1]), z2(in2[2]);
+		AD::Var<double> f2 = scalar_function(x2, y2, z2);
+		f2.backward();
+		value = tape.gradient(in2, grad);
+		e = std::max({ std::abs(value - f2.get_value()), std::abs(grad[0] - x2.get_deriv()), std::abs(grad[1] - y2.get_deriv()), std::abs(grad[2] - z2.get_deriv()) });
+		check("磁带换输入重算", e, 1e-12);
+
+		//存到文件再mmap回来
+		std::string path = "test_tape.bin";
+		AD::Tape<double> loaded;
+		bool good = tape.save(path) && loaded.load(path);
+		value = good ? loaded.gradient(in, grad) : 0.0;
+		e = good ? std::max(std::abs(value - f.get_value()), std::abs(grad[2] - ref[2])) : 1e300;
+		check("磁带存取", e, 1e-12);
+		loaded = AD::Tape<double>();
+		std::remove(path.c_str());
+
+		//在NoGradGuard里算出来的操作数作为常量记下
+		AD::Var<double> c(0.0);
+		{
+			AD::NoGradGuard guard;
+			c = sin(AD::Var<double>(1.5)) * AD::Var<double>(2.0);
+		}
+		AD::Var<double> u(0.7);
+		AD::Tape<double> mixed;
+		good = mixed.record(u * c - c, { u });
+		double uin = 0.7;
+		double ug = 0.0;
+		value = good ? mixed.gradient(&uin, &ug) : 0.0;
+		double cv = std::sin(1.5) * 2.0;
+		check("磁带记录不求导的操作数", good ? std::max(std::abs(value - (0.7 * cv - cv)), std::abs(ug - cv)) : 1e300, 1e-12);
+
+		//同一个变量在inputs里出现两次要拒绝，不能只给其中一个位置梯度
+		AD::Tape<double> dup;
+		good = dup.record(f, { x, y, x, z });
+		check("磁带拒绝重复的输入", !good && !dup.is_valid() ? 0 : 1, 0);
+	}
+
+	void test_jacobian()
+	{
+		int n = 12, m = 9;
+		std::vector<AD::Var<double>> x;
+		for (int i = 0; i < n; i++)
+		{
+			x.emplace_back(0.1 + 0.05 * i);
+		}
+		std::vector<AD::Var<double>> y;
+		for (int r = 0; r < m; r++)
+		{
+			AD::Var<double> s(0.0);
+			for (int j = r % 3; j < n; j += 2)
+			{
+				s = s + sin(x[j] * AD::Var<double>(r + 1.0)) * x[(j + r) % n];
+			}
+			y.push_back(s);
+		}
+		Matrix2x<double> jac = AD::jacobian(y, x, 4);
+		//参照：每个输出单独建图、单独反向
+		double e = 0;
+		for (int r = 0; r < m; r++)
+		{
+			std::vector<AD::Var<double>> xx;
+			for (int i = 0; i < n; i++)
+			{
+				xx.emplace_back(0.1 + 0.05 * i);
+			}
+			AD::Var<double> s(0.0);
+			for (int j = r % 3; j < n; j += 2)
+			{
+				s = s + sin(xx[j] * AD::Var<double>(r + 1.0)) * xx[(j + r) % n];
+			}
+			s.backward();
+			for (int i = 0; i < n; i++)
+			{
+				e = std::max(e, std::abs(jac[r][i] - xx[i].get_deriv()));
+			}
+		}
+		check("雅可比矩阵", e, 1e-12);
+	}
+
+	double loss_of(NN::Sequential<double>& net, const Matrix2x<double>& x, const Matrix2x<double>& t)
+	{
+		AD::NoGradGuard guard;
+		Matrix2x<double> g;
+		return NN::mse_loss(net.forward(x), t, g);
+	}
+
+	//反向传播得到的参数梯度、输入梯度和中心差分比，返回最大相对误差
+	double gradient_error(NN::Sequential<double>& net, Matrix2x<double>& x, const Matrix2x<double>& t)
+	{
+		const double h = 1e-6;
+		Matrix2x<double> g;
+		NN::mse_loss(net.forward(x), t, g);
+		Matrix2x<double> dx = net.backward(g);
+		double e = 0;
+		auto compare = [&](double* w, const double* d, std::size_t n) {
+			for (std::size_t k = 0; k < n; k++)
+			{
+				double old = w[k];
+				w[k] = old + h;
+				double lp = loss_of(net, x, t);
+				w[k] = old - h;
+				double lm = loss_of(net, x, t);
+				w[k] = old;
+				e = std::max(e, std::abs((lp - lm) / (2 * h) - d[k]) / (1 + std::abs(d[k])));
+			}
+		};
+		for (auto& p : net.parameters())
+		{
+			compare(p.first->get_data(), p.second->get_data(), p.first->size());
+		}
+		compare(x.get_data(), dx.get_data(), x.size());
+		return e;
+	}
+
+	void test_layers()
+	{
+		{
+			NN::Sequential<double> net;
+			net.add<NN::Dense<double>>(5, 7, NN::Activation::tanh, 1);
+			net.add<NN::Dense<double>>(7, 4, NN::Activation::sigmoid, 2);
+			net.add<NN::Dense<double>>(4, 2, NN::Activation::identity, 3);
+			Matrix2x<double> x(6, 5), t(6, 2);
+			fill(x, 12);
+			fill(t, 13);
+			check("Dense梯度", gradient_error(net, x, t), 1e-6);
+		}
+		{
+			NN::Sequential<double> net;
+			net.add<NN::Conv2D<double>>(2, 7, 6, 3, 3, 1, 1, NN::Activation::tanh, 1);
+			net.add<NN::Pool2D<double>>(NN::Pooling::max, 3, 7, 6, 2);
+			net.add<NN::Dense<double>>(27, 2, NN::Activation::identity, 2);
+			Matrix2x<double> x(5, 84), t(5, 2);
+			fill(x, 14);
+			fill(t, 15);
+			check("Conv2D + 最大池化梯度", gradient_error(net, x, t), 1e-6);
+		}
+		{
+			NN::Sequential<double> net;
+			net.add<NN::Conv1D<double>>(2, 20, 5, 4, 2, 1, NN::Activation::relu, 5);
+			net.add<NN::Pool1D<double>>(NN::Pooling::average, 5, 10, 2);
+			net.add<NN::Dense<double>>(25, 1);
+			Matrix2x<double> x(6, 40), t(6, 1);
+			fill(x, 16);
+			fill(t, 17);
+			check("Conv1D + 平均池化梯度", gradient_error(net, x, t), 1e-6);
+		}
+		{
+			//偏置和激活在gemm收尾里做，和直接按定义算的卷积比；尺寸大到走分块核，步长和补零都不为默认值
+			int c = 3, h = 13, w = 11, f = 10, k = 3, st = 2, pad = 1;
+			NN::Conv2D<double> conv(c, h, w, f, k, st, pad, NN::Activation::relu, 7);
+			std::vector<std::pair<Matrix2x<double>*, Matrix2x<double>*>> ps;
+			conv.parameters(ps);
+			Matrix2x<double>& cw = *ps[0].first;
+			Matrix2x<double>& cb = *ps[1].first;
+			fill(cb, 18);
+			Matrix2x<double> x(9, c * h * w), y;
+			fill(x, 19);
+			conv.predict(x, y);
+			int oh = (h + 2 * pad - k) / st + 1, ow = (w + 2 * pad - k) / st + 1;
+			double e = y.get_col() == oh * ow * f ? 0 : 1e300;
+			for (int s = 0; s < x.get_row() && e < 1e300; s++)
+			{
+				for (int pos = 0; pos < oh * ow; pos++)
+				{
+					for (int q = 0; q < f; q++)
+					{
+						double v = cb[0][q];
+						for (int ky = 0; ky < k; ky++)
+						{
+							for (int kx = 0; kx < k; kx++)
+							{
+								int iy = pos / ow * st - pad + ky, ix = pos % ow * st - pad + kx;
+								if (iy < 0 || iy >= h || ix < 0 || ix >= w)
+								{
+									continue;
+								}
+								for (int ch = 0; ch < c; ch++)
+								{
+									v += x[s][(iy * w + ix) * c + ch] * cw[(ky * k + kx) * c + ch][q];
+								}
+							}
+						}
+						e = std::max(e, std::abs(std::max(v, 0.0) - y[s][pos * f + q]));
+					}
+				}
+			}
+			check("Conv2D前向(偏置和激活在乘法收尾里)", e, 1e-12);
+			check("Conv2D forward与predict一致", max_diff(conv.forward(x), y), 0);
+		}
+	}
+
+	void test_matrix()
+	{
+		Matrix2x<double> a(3, 4);
+		fill(a, 18);
+		Matrix2x<double> copy = a;
+		Matrix2x<double> moved = std::move(a);
+		check("移动构造接管数据", (a.size() == 0 && a.get_data() == nullptr) ? max_diff(moved, copy) : 1e300, 0.0);
+
+		//复合运算和普通运算结果一致
+		Matrix2x<double> b(3, 4);
+		fill(b, 19);
+		Matrix2x<double> sum = moved + b;
+		moved += b;
+		double e = max_diff(moved, sum);
+		Matrix2x<double> scaled = moved * 2.0;
+		moved *= 2.0;
+		e = std::max(e, max_diff(moved, scaled));
+		check("复合赋值运算", e, 0.0);
+
+		//越界下标得到一行0，而不是空指针
+		const Matrix2x<double>& cm = moved;
+		const double* low = cm[-1];
+		const double* high = cm[3];
+		bool good = low != nullptr && high != nullptr;
+		for (int j = 0; good && j < 4; j++)
+		{
+			good = low[j] == 0.0 && high[j] == 0.0;
+		}
+		moved[7][2] = 5.0;
+		check("越界下标返回替身行", good && cm[2] != nullptr ? 0.0 : 1.0, 0.0);
+	}
+
+	void test_sparse()
+	{
+		//随机稀疏矩阵，带重复的三元组(应当累加)
+		int rows = 57, cols = 43;
+		std::mt19937 gen(20);
+		std::uniform_int_distribution<int> pick_row(0, rows - 1), pick_col(0, cols - 1);
+		std::uniform_real_distribution<double> dist(-1.0, 1.0);
+		std::vector<Eigen1::Triplet<double>> triplets;
+		Matrix2x<double> dense(rows, cols);
+		for (int k = 0; k < 400; k++)
+		{
+			int i = pick_row(gen), j = pick_col(gen);
+			double v = dist(gen);
+			triplets.push_back(Eigen1::Triplet<double>(i, j, v));
+			dense[i][j] += v;
+		}
+		Eigen1::SparseMatrix<double> a(rows, cols, triplets);
+		double e = max_diff(a.to_dense(), dense);
+		Matrix2x<double> at = a.transpose().to_dense();
+		for (int i = 0; i < rows; i++)
+		{
+			for (int j = 0; j < cols; j++)
+			{
+				e = std::max(e, std::abs(at[j][i] - dense[i][j]));
+			}
+		}
+		e = std::max(e, std::abs(a.coeff(triplets[0].row, triplets[0].col) - dense[triplets[0].row][triplets[0].col]));
+		check("稀疏矩阵组装和转置", e, 1e-15);
+
+		std::vector<double> x(cols);
+		for (double& v : x)
+		{
+			v = dist(gen);
+		}
+		std::vector<double> y = a * x;
+		e = 0;
+		for (int i = 0; i < rows; i++)
+		{
+			double s = 0;
+			for (int j = 0; j < cols; j++)
+			{
+				s += dense[i][j] * x[j];
+			}
+			e = std::max(e, std::abs(s - y[i]));
+		}
+		check("稀疏矩阵乘向量", e, 1e-13);
+
+		Matrix2x<double> b(cols, 9), c(rows, 9);
+		fill(b, 21);
+		fill(c, 22);
+		Matrix2x<double> ref = reference_gemm(false, false, 0.5, dense, b, 2.0, c);
+		spmm(0.5, a, b, 2.0, c);
+		check("稀疏乘稠密", max_diff(c, ref), 1e-13);
+	}
+
+	void test_memory()
+	{
+		//对齐，并且同一级的块释放后再申请会直接复用
+		void* p = Eigen1::pool_allocate(1000);
+		bool good = reinterpret_cast<std::uintptr_t>(p) % 64 == 0;
+		Eigen1::pool_deallocate(p, 1000);
+		void* q = Eigen1::pool_allocate(900);
+		good = good && q == p;
+		Eigen1::pool_deallocate(q, 900);
+		Matrix2x<double> m(7, 13);
+		good = good && reinterpret_cast<std::uintptr_t>(m.get_data()) % 64 == 0;
+		check("内存池对齐和复用", good ? 0.0 : 1.0, 0.0);
+
+		//工作区只增不减，够用时返回同一块
+		Eigen1::Workspace ws;
+		double* a = ws.get<double>(Eigen1::Workspace::ws_user, 100);
+		double* b = ws.get<double>(Eigen1::Workspace::ws_user, 50);
+		double* c = ws.get<double>(Eigen1::Workspace::ws_user, 1000);
+		double* d = ws.get<double>(Eigen1::Workspace::ws_user, 1000);
+		good = a == b && c == d && reinterpret_cast<std::uintptr_t>(c) % 64 == 0 && ws.capacity() >= 1000 * sizeof(double);
+		ws.release();
+		good = good && ws.capacity() == 0;
+		check("工作区复用和释放", good ? 0.0 : 1.0, 0.0);
+	}
+
+	//按给定的文件头写一个二进制矩阵文件，数据区放count个double
+	void write_matrix_file(const std::string& path, const Eigen1::MatrixFileHeader& h, const std::vector<double>& data)
+	{
+		std::FILE* f = Eigen1::detail::open_file(path, "wb");
+		if (f == nullptr)
+		{
+			return;
+		}
+		std::fwrite(&h, sizeof(h), 1, f);
+		if (!data.empty())
+		{
+			std::fwrite(data.data(), sizeof(double), data.size(), f);
+		}
+		std::fclose(f);
+	}
+
+	void test_io()
+	{
+		std::string path = "test_matrix.bin";
+		Matrix2x<double> a(5, 7);
+		fill(a, 23);
+		bool good = Eigen1::save_binary(a, path);
+		Matrix2x<double> b = Eigen1::load_binary<double>(path);
+		Eigen1::MappedMatrix<double> mapped(path);
+		double e = good ? max_diff(a, b) : 1e300;
+		e = mapped.is_open() ? std::max(e, max_diff(a, mapped.to_matrix2x())) : 1e300;
+		e = std::max(e, std::abs(mapped[4][6] - a[4][6]));
+		mapped = Eigen1::MappedMatrix<double>();
+		check("二进制存取和mmap", e, 0.0);
+
+		//按列存储(转置布局)的文件，用步长描述
+		Eigen1::MatrixFileHeader h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, Eigen1::detail::matrix_magic, 8);
+		h.version = Eigen1::detail::matrix_version;
+		h.dtype = Eigen1::dtype_of<double>::value;
+		h.rows = 5;
+		h.cols = 7;
+		h.row_stride = 1;
+		h.col_stride = 5;
+		h.data_offset = sizeof(h);
+		std::vector<double> column_major(35);
+		for (int i = 0; i < 5; i++)
+		{
+			for (int j = 0; j < 7; j++)
+			{
+				column_major[j * 5 + i] = a[i][j];
+			}
+		}
+		write_matrix_file(path, h, column_major);
+		check("按步长读转置布局", max_diff(Eigen1::load_binary<double>(path), a), 0.0);
+
+		//坏文件头：行数超过int、步长让数据范围溢出、数据偏移落在文件头里、文件太短，都必须拒绝
+		Eigen1::MatrixFileHeader bad[4] = { h, h, h, h };
+		bad[0].rows = (std::int64_t)1 << 40;
+		bad[1].row_stride = (std::int64_t)1 << 62;
+		bad[2].data_offset = 8;
+		bad[3].cols = 8;
+		int rejected = 0;
+		for (const Eigen1::MatrixFileHeader& bh : bad)
+		{
+			write_matrix_file(path, bh, column_major);
+			Matrix2x<double> m = Eigen1::load_binary<double>(path);
+			Eigen1::MappedMatrix<double> mm(path);
+			rejected += m.size() == 0 && !mm.is_open();
+		}
+		check("拒绝损坏的二进制文件头", rejected == 4 ? 0.0 : 1.0, 0.0);
+		std::remove(path.c_str());
+
+		//CSV：表头、空行、科学计数法、负数、行尾没有换行
+		std::string csv = "test_matrix.csv";
+		std::FILE* f = Eigen1::detail::open_file(csv, "wb");
+		if (f != nullptr)
+		{
+			std::fputs("x,y,z\n1.5,-2,3e2\n\n0.125,1e-3,-7.25E+1\r\n4,5,6", f);
+			std::fclose(f);
+		}
+		Matrix2x<double> c = Eigen1::load_csv<double>(csv, ',', true);
+		Matrix2x<double> expect(3, 3);
+		double values[9] = { 1.5, -2, 300, 0.125, 1e-3, -72.5, 4, 5, 6 };
+		std::copy_n(values, 9, expect.get_data());
+		check("CSV读取", max_diff(c, expect), 0.0);
+		std::remove(csv.c_str());
+	}
+
+	void test_optim()
+	{
+		//SGD动量两步：v1 = g，v2 = 0.9 * g + g
+		Matrix2x<double> wa(2, 3), ga(2, 3), wb(2, 3), gb(2, 3);
+		NN::ParameterSet<double> ps;
+		ps.bind({ { &wa, &ga } });
+		NN::SGD<double> sgd(ps, 0.1, 0.9);
+		double e = 0;
+		for (int it = 0; it < 2; it++)
+		{
+			std::fill_n(ga.get_data(), ga.size(), 1.0);
+			sgd.step();
+			e = std::max(e, std::abs(ga[1][2]));
+		}
+		e = std::max(e, std::abs(wa[0][0] + 0.1 * (1.0 + 1.9)));
+		check("SGD动量更新", e, 1e-15);
+
+		//换绑到同样大小的另一批参数，动量必须清零：第一步只走 -lr * g
+		ps.bind({ { &wb, &gb } });
+		std::fill_n(gb.get_data(), gb.size(), 1.0);
+		sgd.step();
+		check("SGD换绑后清空动量", std::abs(wb[1][1] + 0.1), 1e-15);
+
+		//Adam：第一步偏差修正后 m_hat / sqrt(v_hat) = sign(g)，换绑后同样从第一步算起。
+		//(wa、wb还映射在ps的数组上，所以这里换一组新矩阵)
+		Matrix2x<double> wc(2, 3), gc(2, 3), wd(2, 3), gd(2, 3);
+		NN::ParameterSet<double> ps2;
+		ps2.bind({ { &wc, &gc } });
+		NN::Adam<double> adam(ps2, 0.01);
+		for (int it = 0; it < 3; it++)
+		{
+			std::fill_n(gc.get_data(), gc.size(), 1.0);
+			adam.step();
+		}
+		e = std::abs(wc[0][1] + 0.03);
+		ps2.bind({ { &wd, &gd } });
+		std::fill_n(gd.get_data(), gd.size(), -2.0);
+		adam.step();
+		e = std::max(e, std::abs(wd[0][1] - 0.01));
+		check("Adam更新及换绑后重置", e, 1e-9);
+	}
+
+	void test_data()
+	{
+		//103个样本、批大小10：每轮11批，最后一批3行，每个样本每轮恰好出现一次，且x、y对得上
+		Matrix2x<double> x(103, 3), y(103, 1);
+		for (int i = 0; i < 103; i++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				x[i][k] = i * 10 + k;
+			}
+			y[i][0] = i;
+		}
+		NN::DataLoader<double> loader(x, y, 10, true, false, 3, 7);
+		bool good = loader.x().size() == 0 && loader.y().size() == 0;
+		for (int epoch = 0; epoch < 3; epoch++)
+		{
+			std::vector<int> seen(103, 0);
+			int batches = 0;
+			int last_rows = 0;
+			while (loader.next())
+			{
+				batches++;
+				const Matrix2x<double>& bx = loader.x();
+				const Matrix2x<double>& by = loader.y();
+				last_rows = loader.rows();
+				good = good && bx.get_row() == last_rows && by.get_row() == last_rows;
+				for (int i = 0; i < bx.get_row(); i++)
+				{
+					int id = (int)by[i][0];
+					seen[id]++;
+					good = good && bx[i][2] == id * 10 + 2;
+				}
+			}
+			good = good && batches == 11 && last_rows == 3 && loader.x().size() == 0;
+			good = good && std::count(seen.begin(), seen.end(), 1) == 103;
+		}
+		check("数据加载器每轮覆盖全部样本", good ? 0.0 : 1.0, 0.0);
+
+		Matrix2x<double> no_label;
+		NN::DataLoader<double> dropping(x, no_label, 50, false, true);
+		int count = 0;
+		while (dropping.next())
+		{
+			count++;
+		}
+		check("数据加载器丢弃不满的最后一批", count == 2 ? 0.0 : 1.0, 0.0);
+	}
+
+	void test_no_grad()
+	{
+		//NoGradGuard里的运算只算数值、不建节点，可以嵌套，出了作用域恢复求导
+		AD::Var<double> x(0.4), y(1.3);
+		AD::Var<double> with_grad = scalar_function(x, y, x);
+		bool good = with_grad.nodeptr != nullptr;
+		{
+			AD::NoGradGuard outer;
+			{
+				AD::NoGradGuard inner;
+			}
+			AD::Var<double> plain = scalar_function(x, y, x);
+			good = good && !AD::grad_enabled() && plain.nodeptr == nullptr && plain.get_value() == with_grad.get_value();
+		}
+		good = good && AD::grad_enabled();
+		check("NoGradGuard只算数值", good ? 0.0 : 1.0, 0.0);
+
+		//网络在不求导模式下的前向和正常前向结果相同
+		NN::Sequential<double> net;
+		net.add<NN::Dense<double>>(6, 9, NN::Activation::relu, 1);
+		net.add<NN::Dense<double>>(9, 4, NN::Activation::sigmoid, 2);
+		Matrix2x<double> input(5, 6);
+		fill(input, 24);
+		Matrix2x<double> normal = net.forward(input);
+		double e;
+		{
+			AD::NoGradGuard guard;
+			e = max_diff(net.forward(input), normal);
+		}
+		check("网络不求导前向", e, 0.0);
+	}
+
+	void test_quant()
+	{
+		//本机支持的每个点积内核都要和普通循环逐位一致，含±127的极端值
+		std::mt19937 gen(37);
+		std::uniform_int_distribution<int> dist(-127, 127);
+		const int n = 32 * 9;
+		std::vector<int8_t> buf(5 * n);
+		for (std::size_t k = 0; k < buf.size(); k++)
+		{
+			buf[k] = (int8_t)(k % 17 == 0 ? (k % 2 == 0 ? 127 : -127) : dist(gen));
+		}
+		const int8_t* a = buf.data();
+		const int8_t* b = buf.data() + n;
+		int32_t want[4];
+		Eigen1::detail::dot4_s8_scalar(a, b, b + n, b + 2 * n, b + 3 * n, n, want);
+		for (const Eigen1::detail::Dot4Kernel& kern : Eigen1::detail::dot4_kernels())
+		{
+			if (!kern.supported)
+			{
+				std::cout << "跳过  本机不支持的点积内核 " << kern.name << std::endl;
+				continue;
+			}
+			int32_t got[4];
+			kern.fn(a, b, b + n, b + 2 * n, b + 3 * n, n, got);
+			double e = 0;
+			for (int r = 0; r < 4; r++)
+			{
+				e = std::max(e, std::abs((double)got[r] - want[r]));
+			}
+			check(std::string("int8点积内核 ") + kern.name, e, 0);
+		}
+		std::cout << "int8乘法选用的内核 " << Eigen1::quant_kernel_name() << std::endl;
+
+		//反量化乘法和浮点乘法比，误差在量化步长的量级；列数凑不满4的倍数也要对
+		Matrix2x<double> x(37, 70), w(70, 23), bias(1, 23), zero(37, 23);
+		fill(x, 11);
+		fill(w, 12);
+		fill(bias, 13);
+		Eigen1::QuantizedMatrix qx = Eigen1::quantize(x, Eigen1::QuantMode::per_row);
+		Eigen1::QuantizedMatrix qw = Eigen1::quantize_transposed(w, Eigen1::QuantMode::per_row);
+		Matrix2x<double> got;
+		Eigen1::gemm_dequant(qx, qw, bias.get_data(), got);
+		Matrix2x<double> want_f = reference_gemm(false, false, 1.0, x, w, 0.0, zero);
+		for (int i = 0; i < want_f.get_row(); i++)
+		{
+			for (int j = 0; j < want_f.get_col(); j++)
+			{
+				want_f[i][j] += bias[0][j];
+			}
+		}
+		check("int8反量化乘法", max_diff(got, want_f), 0.1);
+	}
+
+	void test_stats()
+	{
+		//每个计数点按操作名分开：拷贝构造、数乘(里面先拷贝一份b)、求逆各自记在自己的名下
+		Matrix2x<double> a(4, 4);
+		fill(a, 40);
+		for (int i = 0; i < 4; i++)
+		{
+			a[i][i] += 4;
+		}
+		Eigen1::StatsScope scope;
+		Matrix2x<double> b = a;
+		Eigen1::StatCounters r = scope.report();
+		double e = std::abs((double)r.count_of("copy constructor") - 1) + (double)r.count_of("scalar operator*");
+		scope.restart();
+		Matrix2x<double> c = 2.0 * b;
+		r = scope.report();
+		e += std::abs((double)r.count_of("scalar operator*") - 1) + std::abs((double)r.count_of("copy constructor") - 1);
+		scope.restart();
+		Matrix2x<double> d = c.inv();
+		r = scope.report();
+		e += std::abs((double)r.count_of("inv") - 1) + (double)r.count_of("operator*") + (double)r.count_of("copy constructor");
+		check("分配计数按操作名区分", e, 0);
+
+		//堆计数要能看到std::vector扩容，而分派并行任务不能上堆
+		scope.restart();
+		std::vector<double> grow;
+		for (int i = 0; i < 100; i++)
+		{
+			grow.push_back(i);
+		}
+		check("堆计数看到vector扩容", r.heap_counted && scope.report().count[Eigen1::stat_heap] > 0 ? 0 : 1, 0);
+		double x0 = 1, x1 = 2, x2 = 3, x3 = 4, sum = 0;
+		scope.restart();
+		Eigen1::parallel_for(0, 4, 1, [&](long long lo, long long hi) {
+			for (long long i = lo; i < hi; i++)
+			{
+				sum += x0 + x1 + x2 + x3;
+			}
+		});
+		check("parallel_for不分配内存", (double)scope.report().allocations(), 0);
+
+		//Dense + SGD训练一步：第一步各缓冲区、工作区、优化器状态就位，第二步不能再有任何分配
+		NN::Sequential<double> net;
+		net.add<NN::Dense<double>>(12, 40, NN::Activation::relu, 3);
+		net.add<NN::Dense<double>>(40, 3, NN::Activation::identity, 4);
+		Matrix2x<double> x(200, 12), t(200, 3), g;
+		fill(x, 41);
+		fill(t, 42);
+		NN::SGD<double> sgd(net.flat_parameters(), 0.01, 0.9);
+		unsigned long long steps[2];
+		for (int it = 0; it < 2; it++)
+		{
+			scope.restart();
+			NN::mse_loss(net.forward(x), t, g);
+			net.backward(g);
+			sgd.step();
+			Eigen1::StatCounters s = scope.report();
+			steps[it] = s.allocations();
+			if (it == 1 && steps[it] != 0)
+			{
+				s.print();
+			}
+		}
+		check("Dense + SGD第一步有分配(计数在工作)", steps[0] > 0 ? 0 : 1, 0);
+		check("Dense + SGD第二步零分配", (double)steps[1], 0);
+	}
+
+	void test_reduce()
+	{
+		//整体归约和逐个元素用long double累加的结果比，长度超过多线程的门槛、也不是8的倍数
+		Matrix2x<double> a(401, 503);
+		fill(a, 50);
+		long double s = 0, s2 = 0, s1 = 0;
+		double mx = -1e300, mn = 1e300, mabs = 0;
+		for (std::size_t k = 0; k < a.size(); k++)
+		{
+			double v = a.get_data()[k];
+			s += v;
+			s2 += (long double)v * v;
+			s1 += std::abs(v);
+			mx = std::max(mx, v);
+			mn = std::min(mn, v);
+			mabs = std::max(mabs, std::abs(v));
+		}
+		check("求和", std::abs(Eigen1::sum(a) - (double)s), 1e-10);
+		check("平方和", std::abs(Eigen1::squared_norm(a) - (double)s2) / (double)s2, 1e-14);
+		check("范数", std::abs(Eigen1::norm(a) - std::sqrt((double)s2)), 1e-10);
+		check("绝对值之和", std::abs(Eigen1::norm1(a) - (double)s1) / (double)s1, 1e-14);
+		check("最大最小值", std::abs(Eigen1::max_coeff(a) - mx) + std::abs(Eigen1::min_coeff(a) - mn) + std::abs(Eigen1::norm_inf(a) - mabs), 0);
+
+		//按行、按列求和
+		Matrix2x<double> rs = Eigen1::row_sum(a), cs = Eigen1::col_sum(a);
+		double e = 0;
+		for (int i = 0; i < a.get_row(); i++)
+		{
+			long double r = 0;
+			for (int j = 0; j < a.get_col(); j++)
+			{
+				r += a[i][j];
+			}
+			e = std::max(e, std::abs(rs[i][0] - (double)r));
+		}
+		for (int j = 0; j < a.get_col(); j++)
+		{
+			long double c = 0;
+			for (int i = 0; i < a.get_row(); i++)
+			{
+				c += a[i][j];
+			}
+			e = std::max(e, std::abs(cs[0][j] - (double)c));
+		}
+		check("按行、按列求和", e, 1e-12);
+
+		//按列求和的Kahan补偿：1后面跟10000个1e-16，顺序累加每个1e-16都被舍掉，结果还是1
+		Matrix2x<double> k(10001, 2);
+		for (int i = 1; i < k.get_row(); i++)
+		{
+			k[i][0] = 1e-16;
+			k[i][1] = -1e-16;
+		}
+		k[0][0] = 1;
+		k[0][1] = 1;
+		cs = Eigen1::col_sum(k);
+		check("按列求和的补偿", std::abs(cs[0][0] - (1 + 1e-12)) + std::abs(cs[0][1] - (1 - 1e-12)), 1e-15);
+
+		//回归：两块部分和合并时TwoSum的舍入误差要留在补偿里。
+		//(1e16) + (1) 合并丢掉的1记在comp里，再并上(-1e16)后 sum - comp 还是1，丢掉误差时得0
+		double sa = 1e16, ca = 0, sb = 1, cb = 0, sc = -1e16, cc = 0;
+		Eigen1::detail::kahan_merge(&sa, &ca, &sb, &cb, 1);
+		Eigen1::detail::kahan_merge(&sa, &ca, &sc, &cc, 1);
+		check("Kahan部分和合并保留舍入误差", std::abs((sa - ca) - 1), 0);
+
+		//均方误差的损失值直接累加平方和，和逐项算的比
+		Matrix2x<double> y(37, 9), t(37, 9), g;
+		fill(y, 51);
+		fill(t, 52);
+		long double ref = 0;
+		for (std::size_t q = 0; q < y.size(); q++)
+		{
+			long double d = (long double)y.get_data()[q] - t.get_data()[q];
+			ref += d * d;
+		}
+		ref = 0.5L * ref / y.get_row();
+		check("均方误差损失", std::abs(NN::mse_loss(y, t, g) - (double)ref) / (double)ref, 1e-14);
+	}
+
+	//generated_grad.h就是write_cpp对这张磁带的输出：scalar_function再加上一个在不求导模式下算出的常量
+	void build_codegen_tape(AD::Tape<double>& tape)
+	{
+		AD::Var<double> x(0.4), y(1.3), z(0.7);
+		AD::Var<double> c(0.0);
+		{
+			AD::NoGradGuard guard;
+			c = AD::Var<double>(0.75) + AD::Var<double>(3.0);
+		}
+		tape.record(scalar_function(x, y, z) + x * c / z, { x, y, z });
+	}
+
+	std::string read_text(const std::string& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	void test_codegen()
+	{
+		//编译进来的生成代码和磁带逐点比较值和梯度，grad为nullptr时只求值
+		AD::Tape<double> tape;
+		build_codegen_tape(tape);
+		double pts[4][3] = { { 0.4, 1.3, 0.7 }, { -0.3, 0.8, 1.9 }, { 1.7, 2.2, -0.4 }, { 0.05, 0.6, 0.3 } };
+		double e = tape.is_valid() ? 0 : 1e300;
+		for (auto& p : pts)
+		{
+			double g1[3], g2[3];
+			double v1 = tape.gradient(p, g1);
+			double v2 = generated_grad(p, g2);
+			e = std::max({ e, std::abs(v1 - v2), std::abs(generated_grad(p, nullptr) - v1) });
+			for (int k = 0; k < 3; k++)
+			{
+				e = std::max(e, std::abs(g1[k] - g2[k]));
+			}
+		}
+		check("生成的代码与磁带的梯度一致", e, 1e-12);
+
+		//重新生成一遍要和仓库里的generated_grad.h一字不差，改了生成器就要重新生成这个文件
+		std::string file = __FILE__;
+		std::string saved = read_text(file.substr(0, file.find_last_of("/\\") + 1) + "generated_grad.h");
+		std::string path = "test_codegen.h";
+		if (saved.empty())
+		{
+			std::cout << "跳过  找不到generated_grad.h，不检查重新生成的代码" << std::endl;
+			return;
+		}
+		bool good = AD::write_cpp(tape, "generated_grad", path);
+		check("重新生成的代码与generated_grad.h相同", good && read_text(path) == saved ? 0 : 1, 0);
+		std::remove(path.c_str());
+	}
+}
+
+int main()
+{
+	test_gemm();
+	test_inverse();
+	test_solver();
+	test_tape();
+	test_jacobian();
+	test_layers();
+	test_matrix();
+	test_sparse();
+	test_memory();
+	test_io();
+	test_optim();
+	test_data();
+	test_no_grad();
+	test_quant();
+	test_stats();
+	test_reduce();
+	test_codegen();
+	if (failures == 0)
+	{
+		std::cout << "全部通过" << std::endl;
+	}
+	else
+	{
+		std::cout << failures << "项失败" << std::endl;
+	}
+	return failures;
+}